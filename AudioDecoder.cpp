@@ -5,10 +5,41 @@
 #include <fcntl.h>
 #include <cstring>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include "SimdKernels.h"
 
-AudioDecoder::AudioDecoder() 
-    : sample_rate(0), channels(0), loaded(false),
-      input_stream(nullptr), file_size(0), file_descriptor(-1) {
+namespace {
+
+// Independent libmad decoder state, for decoding away from the main stream
+struct MadState {
+    struct mad_stream stream;
+    struct mad_frame frame;
+    struct mad_synth synth;
+
+    MadState() {
+        mad_stream_init(&stream);
+        mad_frame_init(&frame);
+        mad_synth_init(&synth);
+    }
+
+    ~MadState() {
+        mad_synth_finish(&synth);
+        mad_frame_finish(&frame);
+        mad_stream_finish(&stream);
+    }
+};
+
+} // namespace
+
+AudioDecoder::AudioDecoder()
+    : sample_storage(SampleStorage::Float32), load_cancel(nullptr), decoded_frames(0), decode_threads(0),
+      sample_rate(0), channels(0), loaded(false),
+      input_stream(nullptr), file_size(0), file_descriptor(-1), file_mtime(0),
+      pcm_cache(nullptr), cache_stop(false),
+      streaming(false), stream_start(0),
+      stream_stop(false), stream_finished(false) {
     mad_stream_init(&mad_stream);
     mad_synth_init(&mad_synth);
     mad_frame_init(&mad_frame);
@@ -23,88 +54,485 @@ AudioDecoder::~AudioDecoder() {
 
 bool AudioDecoder::loadFile(const std::string& filename) {
     clear();
-    return decodeMP3(filename);
+    if (!mapFile(filename)) {
+        return false;
+    }
+    if (WavFile::isWav(input_stream, file_size)) {
+        return loadWAV();
+    }
+    if (loadCachedMP3()) {
+        return true;
+    }
+    if (!decodeMP3()) {
+        return false;
+    }
+    if (sample_storage == SampleStorage::Float32) {
+        startCacheWrite();
+    }
+    return true;
 }
 
-bool AudioDecoder::decodeMP3(const std::string& filename) {
+bool AudioDecoder::mapFile(const std::string& filename) {
     // Open file
     FILE* fp = fopen(filename.c_str(), "rb");
     if (!fp) {
         std::cerr << "Failed to open file: " << filename << std::endl;
         return false;
     }
-    
+
     file_descriptor = fileno(fp);
-    
+
     // Get file metadata
     struct stat metadata;
     if (fstat(file_descriptor, &metadata) < 0) {
         std::cerr << "Failed to stat file: " << filename << std::endl;
         fclose(fp);
+        file_descriptor = -1;
         return false;
     }
-    
+
     file_size = metadata.st_size;
+    file_mtime = metadata.st_mtime;
     std::cout << "File size: " << file_size << " bytes" << std::endl;
-    
+
     // Memory map the file
     input_stream = (const unsigned char*) mmap(0, file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
     if (input_stream == MAP_FAILED) {
         std::cerr << "Failed to mmap file" << std::endl;
+        input_stream = nullptr;
         fclose(fp);
         file_descriptor = -1;
         return false;
     }
-    
-    // Don't close fp yet - we need the file descriptor for munmap later
-    // Store it but don't close until cleanup
-    
-    // Initialize libmad decoder
-    mad_stream_buffer(&mad_stream, input_stream, file_size);
-    
-    // Decode all frames
-    while (1) {
+
+    // The mapping stays valid after the FILE* is closed
+    fclose(fp);
+    this->filename = filename;
+    return true;
+}
+
+bool AudioDecoder::decodeMP3() {
+    if (!buildIndex()) {
+        cleanup();
+        return false;
+    }
+
+    // The index gives the exact output size, so every frame range can be
+    // decoded straight into its final slot in parallel
+    size_t total = frame_index.totalSamples();
+    size_t frames = frame_index.frameCount();
+    bool allocated = false;
+    if (sample_storage == SampleStorage::Float32) {
+        allocated = samples.allocate(channels, total);
+    } else {
+        CompactSampleBuffer::Format format = (sample_storage == SampleStorage::Int16)
+            ? CompactSampleBuffer::Format::Int16 : CompactSampleBuffer::Format::Float16;
+        allocated = compact_samples.allocate(format, channels, total);
+    }
+    if (!allocated) {
+        std::cerr << "Failed to allocate " << channels << " x " << total << " samples" << std::endl;
+        cleanup();
+        return false;
+    }
+
+    decoded_frames.store(0);
+    unsigned int workers = decode_threads ? decode_threads : std::max(1u, std::thread::hardware_concurrency());
+    workers = (unsigned int)std::min<size_t>(workers, std::max<size_t>(1, frames / MIN_FRAMES_PER_WORKER));
+
+    bool decoded = true;
+    if (workers == 1) {
+        decoded = decodeSlice(0, total);
+    } else {
+        // Each worker has its own libmad state and primes itself from the
+        // frames just before its range (see Mp3FrameIndex::primingFrame)
+        std::vector<std::thread> threads;
+        std::vector<char> results(workers, 0);
+        for (unsigned int w = 0; w < workers; w++) {
+            size_t first_frame = frames * w / workers;
+            size_t last_frame = frames * (w + 1) / workers;
+            size_t begin = frame_index.frameStartSample(first_frame);
+            size_t end = (last_frame < frames) ? frame_index.frameStartSample(last_frame) : total;
+            char* result = &results[w];
+            threads.emplace_back([this, begin, end, result]() {
+                *result = decodeSlice(begin, end);
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+        decoded = std::find(results.begin(), results.end(), 0) == results.end();
+    }
+
+    // A slice that was not decoded leaves its part of the (uninitialized)
+    // storage as garbage, so the whole load fails
+    if (isLoadCancelled() || !decoded) {
+        if (decoded) {
+            std::cout << "Decoding cancelled: " << filename << std::endl;
+        } else {
+            std::cerr << "Failed to allocate decode scratch for: " << filename << std::endl;
+        }
+        cleanup();
+        samples.clear();
+        compact_samples.clear();
+        return false;
+    }
+
+    loaded = true;
+    std::cout << "Decoded " << total << " frames x " << channels
+              << " channel(s) on " << workers << " thread(s)"
+              << (compact_samples.empty() ? "" : " into 16-bit storage") << std::endl;
+
+    return true;
+}
+
+bool AudioDecoder::decodeSlice(size_t begin, size_t end) {
+    // Decode in chunks so progress can be reported and a cancel noticed;
+    // each chunk re-primes like a worker boundary does (~1% extra work).
+    // Compact storage decodes through a float scratch block and compresses it.
+    bool compact = (sample_storage != SampleStorage::Float32);
+    SampleBuffer scratch;
+    std::array<float*, MAX_CHANNELS> out = {};
+    if (compact) {
+        if (!scratch.allocate(channels, std::min(DECODE_CHUNK_FRAMES, end - begin))) {
+            return false;
+        }
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            out[ch] = scratch.channel(ch);
+        }
+    }
+
+    for (size_t pos = begin; pos < end && !isLoadCancelled(); pos += DECODE_CHUNK_FRAMES) {
+        size_t count = std::min(DECODE_CHUNK_FRAMES, end - pos);
+        if (compact) {
+            decodeRange(pos, count, out.data());
+            for (unsigned int ch = 0; ch < channels; ch++) {
+                compact_samples.write(ch, pos, scratch.channel(ch), count);
+            }
+        } else {
+            decodeRange(pos, count, channelPointers(pos).data());
+        }
+
+        size_t done = decoded_frames.fetch_add(count) + count;
+        if (progress_callback) {
+            progress_callback(done, frame_index.totalSamples());
+        }
+    }
+    return true;
+}
+
+bool AudioDecoder::loadCachedMP3() {
+    if (!pcm_cache || !pcm_cache->isEnabled()) {
+        return false;
+    }
+
+    std::string key = pcm_cache->makeKey(input_stream, file_size, file_mtime);
+    if (!pcm_cache->load(key, samples, sample_rate)) {
+        return false;
+    }
+
+    channels = samples.getChannels();
+    loaded = true;
+    std::cout << "Sample rate: " << sample_rate << " Hz" << std::endl;
+    std::cout << "Channels: " << channels << std::endl;
+    std::cout << "Mapped " << samples.getFrames() << " frames from PCM cache" << std::endl;
+    return true;
+}
+
+void AudioDecoder::startCacheWrite() {
+    if (!pcm_cache || !pcm_cache->isEnabled()) {
+        return;
+    }
+
+    // Playback can start right away; the write only reads samples
+    std::string key = pcm_cache->makeKey(input_stream, file_size, file_mtime);
+    cache_stop.store(false);
+    cache_thread = std::thread([this, key]() {
+        if (pcm_cache->store(key, samples, sample_rate, cache_stop)) {
+            std::cout << "Stored decoded PCM in cache (" << key << ")" << std::endl;
+        }
+    });
+}
+
+void AudioDecoder::stopCacheWrite() {
+    cache_stop.store(true);
+    if (cache_thread.joinable()) {
+        cache_thread.join();
+    }
+}
+
+bool AudioDecoder::loadWAV() {
+    if (!wav_file.open(input_stream, file_size)) {
+        std::cerr << "Failed to parse WAV file: " << filename << std::endl;
+        cleanup();
+        return false;
+    }
+
+    // PCM is served straight from the mapping; tell the kernel we read it in order
+    madvise((void*)input_stream, file_size, MADV_SEQUENTIAL);
+
+    sample_rate = wav_file.getSampleRate();
+    channels = wav_file.getChannels();
+    loaded = true;
+    std::cout << "Sample rate: " << sample_rate << " Hz" << std::endl;
+    std::cout << "Channels: " << channels << std::endl;
+    std::cout << "Mapped " << wav_file.getFrames() << " WAV frames" << std::endl;
+    return true;
+}
+
+bool AudioDecoder::buildIndex() {
+    // Header-only scan: gives the exact length and makes seeking O(1)
+    if (!frame_index.build(input_stream, file_size)) {
+        std::cerr << "No MPEG audio frames found in: " << filename << std::endl;
+        return false;
+    }
+
+    sample_rate = frame_index.getSampleRate();
+    channels = frame_index.getChannels();
+    std::cout << "Sample rate: " << sample_rate << " Hz" << std::endl;
+    std::cout << "Channels: " << channels << std::endl;
+    std::cout << "Indexed " << frame_index.frameCount() << " frames ("
+              << frame_index.totalSamples() << " samples)" << std::endl;
+    return true;
+}
+
+bool AudioDecoder::openStream(const std::string& filename) {
+    clear();
+    if (!mapFile(filename)) {
+        return false;
+    }
+
+    // WAV needs no decoding, so the mapped file already plays instantly
+    if (WavFile::isWav(input_stream, file_size)) {
+        return loadWAV();
+    }
+
+    if (!buildIndex()) {
+        cleanup();
+        return false;
+    }
+
+    stream_buffer.setCapacity(STREAM_BUFFER_FRAMES * channels);
+    streaming = true;
+    loaded = true;
+    startStreamThread(0);
+    return true;
+}
+
+void AudioDecoder::startStreamThread(size_t position) {
+    // Start decoding a few frames early so the target frame is primed
+    size_t first = frame_index.primingFrame(frame_index.frameForSample(position));
+    size_t offset = frame_index.frameOffset(first);
+
+    resetMad();
+    mad_stream_buffer(&mad_stream, input_stream + offset, file_size - offset);
+    stream_start = position;
+    stream_stop.store(false);
+    stream_finished.store(false);
+    stream_thread = std::thread(&AudioDecoder::streamProducer, this);
+}
+
+void AudioDecoder::stopStreamThread() {
+    stream_stop.store(true);
+    if (stream_thread.joinable()) {
+        stream_thread.join();
+    }
+}
+
+std::array<float*, AudioDecoder::MAX_CHANNELS> AudioDecoder::channelPointers(size_t position) {
+    std::array<float*, MAX_CHANNELS> out = {};
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        out[ch] = samples.channel(ch) + position;
+    }
+    return out;
+}
+
+void AudioDecoder::streamProducer() {
+    float planar[MAX_CHANNELS][1152];
+    float pcm[1152 * MAX_CHANNELS];
+    size_t next_position = 0;
+
+    while (!stream_stop.load()) {
         if (mad_frame_decode(&mad_frame, &mad_stream)) {
             if (MAD_RECOVERABLE(mad_stream.error)) {
                 continue;
-            } else if (mad_stream.error == MAD_ERROR_BUFLEN) {
-                break;
-            } else {
-                break;
             }
+            break;
         }
-        
-        // Get sample rate from first frame
-        if (sample_rate == 0) {
-            sample_rate = mad_frame.header.samplerate;
-            channels = MAD_NCHANNELS(&mad_frame.header);
-            std::cout << "Sample rate: " << sample_rate << " Hz" << std::endl;
-            std::cout << "Channels: " << channels << std::endl;
-        }
-        
-        // Synthesize frame to PCM
+
         mad_synth_frame(&mad_synth, &mad_frame);
         unsigned int nsamples = mad_synth.pcm.length;
-        
-        // Extract and normalize PCM samples
-        for (unsigned int i = 0; i < nsamples; i++) {
-            // Use left channel (or mono)
-            mad_fixed_t pcm_sample = mad_synth.pcm.samples[0][i];
-            float normalized_sample = (float)(pcm_sample / (float)MAD_F_FULL_24BIT);
-            samples.push_back(normalized_sample);
+
+        // Locate the frame in the track to drop priming output before stream_start
+        size_t frame = frame_index.frameAtOffset(mad_stream.this_frame - input_stream);
+        size_t position = (frame != Mp3FrameIndex::npos) ? frame_index.frameStartSample(frame) : next_position;
+        next_position = position + nsamples;
+        if (next_position <= stream_start) {
+            continue;
+        }
+        size_t skip = (stream_start > position) ? stream_start - position : 0;
+        nsamples -= skip;
+
+        // The ring holds interleaved frames
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            convertPCM(pcmChannel(mad_synth.pcm, ch) + skip, planar[ch], nsamples);
+        }
+        if (channels == 1) {
+            std::copy(planar[0], planar[0] + nsamples, pcm);
+        } else {
+            for (unsigned int i = 0; i < nsamples; i++) {
+                pcm[2 * i] = planar[0][i];
+                pcm[2 * i + 1] = planar[1][i];
+            }
+        }
+        size_t total = nsamples * channels;
+
+        // Wait for the consumer to make room; the buffer bounds how far
+        // ahead of the playback position we decode
+        size_t written = 0;
+        while (written < total && !stream_stop.load()) {
+            written += stream_buffer.write(pcm + written, total - written);
+            if (written < total) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
         }
     }
-    
-    // Close the FILE* but keep file_descriptor for cleanup
-    fclose(fp);
-    // Note: file_descriptor is still valid for munmap in cleanup()
-    loaded = true;
-    std::cout << "Decoded " << samples.size() << " samples" << std::endl;
-    
-    return true;
+
+    stream_finished.store(true);
+}
+
+size_t AudioDecoder::readFrames(size_t start, size_t count, float* const* out) const {
+    if (wav_file.isOpen()) {
+        return wav_file.readFrames(start, count, out);
+    }
+    if (!compact_samples.empty()) {
+        // Expand just the requested block
+        size_t got = 0;
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            got = compact_samples.read(ch, start, count, out[ch]);
+        }
+        return got;
+    }
+    if (streaming || start >= samples.getFrames()) {
+        return 0;
+    }
+    count = std::min(count, samples.getFrames() - start);
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        memcpy(out[ch], samples.channel(ch) + start, count * sizeof(float));
+    }
+    return count;
+}
+
+size_t AudioDecoder::readStream(float* out, size_t frames) {
+    if (!streaming) {
+        return 0;
+    }
+    // Only hand out whole frames; the producer may be mid-way through one
+    frames = std::min(frames, stream_buffer.availableToRead() / channels);
+    return stream_buffer.read(out, frames * channels) / channels;
+}
+
+void AudioDecoder::seekStream(size_t position) {
+    if (!streaming) {
+        return;
+    }
+    stopStreamThread();
+    stream_buffer.clear();
+    startStreamThread(std::min(position, frame_index.totalSamples()));
+}
+
+size_t AudioDecoder::decodeRange(size_t start, size_t count, float* const* out) const {
+    if (!input_stream || frame_index.empty() || start >= frame_index.totalSamples()) {
+        return 0;
+    }
+    count = std::min(count, frame_index.totalSamples() - start);
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        std::fill(out[ch], out[ch] + count, 0.0f); // Frames that fail to decode stay silent
+    }
+
+    size_t target = frame_index.frameForSample(start);
+    size_t first = frame_index.primingFrame(target);
+    size_t offset = frame_index.frameOffset(first);
+    size_t end = start + count;
+
+    // mad_frame/mad_synth are large, keep them off the caller's stack
+    std::unique_ptr<MadState> mad(new MadState());
+    mad_stream_buffer(&mad->stream, input_stream + offset, file_size - offset);
+
+    while (1) {
+        if (mad_frame_decode(&mad->frame, &mad->stream)) {
+            if (MAD_RECOVERABLE(mad->stream.error)) {
+                continue;
+            }
+            break;
+        }
+
+        size_t frame = frame_index.frameAtOffset(mad->stream.this_frame - input_stream);
+        if (frame == Mp3FrameIndex::npos) {
+            continue;
+        }
+        size_t position = frame_index.frameStartSample(frame);
+        if (position >= end) {
+            break;
+        }
+
+        // Priming frames still go through synthesis to fill the filter bank
+        mad_synth_frame(&mad->synth, &mad->frame);
+        size_t frame_end = position + mad->synth.pcm.length;
+        if (frame_end <= start) {
+            continue;
+        }
+
+        size_t from = std::max(position, start);
+        size_t to = std::min(frame_end, end);
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            convertPCM(pcmChannel(mad->synth.pcm, ch) + (from - position), out[ch] + (from - start), to - from);
+        }
+    }
+
+    return count;
+}
+
+size_t AudioDecoder::getLength() const {
+    if (wav_file.isOpen()) {
+        return wav_file.getFrames();
+    }
+    if (!compact_samples.empty()) {
+        return compact_samples.getFrames();
+    }
+    return streaming ? frame_index.totalSamples() : samples.getFrames();
+}
+
+bool AudioDecoder::isStreamFinished() const {
+    return streaming && stream_finished.load() && stream_buffer.availableToRead() == 0;
+}
+
+void AudioDecoder::resetMad() {
+    // Start from a clean decoder state (bit reservoir, overlap and filter banks)
+    mad_synth_finish(&mad_synth);
+    mad_frame_finish(&mad_frame);
+    mad_stream_finish(&mad_stream);
+    mad_stream_init(&mad_stream);
+    mad_frame_init(&mad_frame);
+    mad_synth_init(&mad_synth);
+}
+
+const mad_fixed_t* AudioDecoder::pcmChannel(const struct mad_pcm& pcm, unsigned int ch) {
+    // A mono frame inside a stereo stream feeds both channels
+    return pcm.samples[ch < pcm.channels ? ch : 0];
+}
+
+void AudioDecoder::convertPCM(const mad_fixed_t* in, float* out, unsigned int count) {
+    static_assert(sizeof(mad_fixed_t) == sizeof(int32_t), "libmad built with 32-bit fixed point expected");
+    // libmad's full scale is MAD_F_ONE (28 fractional bits); one multiply per sample
+    SimdKernels::fixedToFloat(reinterpret_cast<const int32_t*>(in), out, count, 1.0f / MAD_F_ONE);
 }
 
 void AudioDecoder::cleanup() {
+    // The producer thread reads from the mapping and the cache writer from
+    // samples, so stop both first
+    stopStreamThread();
+    stopCacheWrite();
+
     if (input_stream != nullptr && input_stream != MAP_FAILED) {
         munmap((void*)input_stream, file_size);
         input_stream = nullptr;
@@ -112,13 +540,20 @@ void AudioDecoder::cleanup() {
     // Note: file_descriptor was from a FILE* that we already closed with fclose()
     // We don't need to close it again, but we reset it
     file_descriptor = -1;
+    file_mtime = 0;
 }
 
 void AudioDecoder::clear() {
+    cleanup();
     samples.clear();
+    compact_samples.clear();
     sample_rate = 0;
     channels = 0;
     loaded = false;
-    cleanup();
+    streaming = false;
+    stream_start = 0;
+    filename.clear();
+    frame_index.clear();
+    wav_file.close();
+    stream_buffer.setCapacity(0);
 }
-
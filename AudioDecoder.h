@@ -3,52 +3,188 @@
 
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <array>
+#include <functional>
 #include <mad.h>
+#include "SampleRingBuffer.h"
+#include "Mp3FrameIndex.h"
+#include "SampleBuffer.h"
+#include "WavFile.h"
+#include "PcmCache.h"
+#include "CompactSampleBuffer.h"
 
 class AudioDecoder {
 public:
+    // How fully decoded MP3 PCM is held in memory
+    enum class SampleStorage {
+        Float32, // SampleBuffer, 4 bytes per sample
+        Int16,   // CompactSampleBuffer, 2 bytes per sample
+        Float16
+    };
+
+    // Called from decode threads with the frames decoded so far
+    using ProgressCallback = std::function<void(size_t decodedFrames, size_t totalFrames)>;
+
     AudioDecoder();
     ~AudioDecoder();
-    
-    // Load and decode an audio file (MP3)
+
+    // Load an audio file. MP3 is decoded up front, split across all cores
+    // (or mapped from the PCM cache when set); WAV is memory-mapped and
+    // converted on demand by readFrames.
     bool loadFile(const std::string& filename);
-    
-    // Get decoded PCM samples (normalized to [-1, 1])
-    const std::vector<float>& getSamples() const { return samples; }
-    
+
+    // Use a decoded-PCM cache for MP3 loads; nullptr disables caching.
+    // Fresh decodes are written to it on a background thread.
+    void setCache(PcmCache* cache) { pcm_cache = cache; }
+
+    // Storage used by the next loadFile. The compact formats halve memory
+    // for long recordings; readFrames expands them block by block. A PCM
+    // cache hit is still mapped as float, since those pages are file-backed.
+    void setSampleStorage(SampleStorage storage) { sample_storage = storage; }
+    SampleStorage getSampleStorage() const { return sample_storage; }
+
+    // Progress reporting and cancellation for loads run on a worker thread.
+    // Once *cancel is set, a running loadFile stops decoding and returns false.
+    void setProgressCallback(ProgressCallback callback) { progress_callback = callback; }
+    void setCancelFlag(const std::atomic<bool>* cancel) { load_cancel = cancel; }
+
+    // Threads used to decode an MP3 in loadFile; 0 (the default) uses one per
+    // core. Callers that already run one decoder per core should pass 1.
+    void setDecodeThreads(unsigned int threads) { decode_threads = threads; }
+
+    // Open an audio file for streaming: a background thread decodes MP3
+    // frames into a bounded ring buffer, so playback can start after the
+    // first frame instead of after the whole file. WAV opens as in loadFile.
+    bool openStream(const std::string& filename);
+
+    // Copy or convert count frames starting at start into one float array
+    // per channel. Works for everything except MP3 streaming mode. Returns
+    // the number of frames produced.
+    size_t readFrames(size_t start, size_t count, float* const* out) const;
+
+    // Read up to frames interleaved frames from the stream, returns how many
+    // were read. Never blocks; safe to call from the audio callback.
+    size_t readStream(float* out, size_t frames);
+
+    // Restart the stream at the given sample using the frame index
+    void seekStream(size_t position);
+
+    // Restart the stream from the beginning of the file
+    void rewindStream() { seekStream(0); }
+
+    // Decode count frames starting at an arbitrary position into one planar
+    // array per channel, without touching the stream. Returns the number of
+    // frames produced.
+    size_t decodeRange(size_t start, size_t count, float* const* out) const;
+
+    // Check if the decoder is in streaming mode
+    bool isStreaming() const { return streaming; }
+
+    // Check if the stream has been fully decoded and consumed
+    bool isStreamFinished() const;
+
+    // Get decoded PCM samples, one array per channel (normalized to [-1, 1]);
+    // empty in streaming mode, with compact storage and for WAV files (use
+    // readFrames)
+    const SampleBuffer& getSamples() const { return samples; }
+
+    // Get total length in frames (samples per channel)
+    size_t getLength() const;
+
+    // Get the frame index (sample position -> byte offset)
+    const Mp3FrameIndex& getFrameIndex() const { return frame_index; }
+
     // Get sample rate
     unsigned int getSampleRate() const { return sample_rate; }
-    
+
     // Get number of channels
     unsigned int getChannels() const { return channels; }
-    
+
+    // Get the path of the loaded file
+    const std::string& getFilename() const { return filename; }
+
     // Check if file is loaded
     bool isLoaded() const { return loaded; }
-    
+
     // Clear loaded data
     void clear();
 
+    static constexpr unsigned int MAX_CHANNELS = 2; // libmad synthesizes at most two
+
 private:
-    std::vector<float> samples;
+    SampleBuffer samples;
+    CompactSampleBuffer compact_samples;
+    SampleStorage sample_storage;
+
+    // Load progress and cancellation
+    ProgressCallback progress_callback;
+    const std::atomic<bool>* load_cancel;
+    std::atomic<size_t> decoded_frames;
+    unsigned int decode_threads;
     unsigned int sample_rate;
     unsigned int channels;
     bool loaded;
-    
+    std::string filename;
+
     // libmad structures
     struct mad_stream mad_stream;
     struct mad_frame mad_frame;
     struct mad_synth mad_synth;
-    
+
     // File mapping
     const unsigned char* input_stream;
     size_t file_size;
     int file_descriptor;
-    
-    static constexpr int MAD_F_FULL_24BIT = 0x007fffff;
-    
-    bool decodeMP3(const std::string& filename);
+    int64_t file_mtime;
+
+    // Decoded-PCM cache and the thread writing the current file to it
+    PcmCache* pcm_cache;
+    std::thread cache_thread;
+    std::atomic<bool> cache_stop;
+
+    // Frame offsets, built by a header-only scan before decoding
+    Mp3FrameIndex frame_index;
+
+    // PCM view into the mapping when the file is a WAV
+    WavFile wav_file;
+
+    // Streaming state
+    bool streaming;
+    size_t stream_start; // Producer drops samples before this position
+    SampleRingBuffer stream_buffer;
+    std::thread stream_thread;
+    std::atomic<bool> stream_stop;
+    std::atomic<bool> stream_finished;
+
+    static constexpr size_t STREAM_BUFFER_FRAMES = 1 << 17; // ~3 s at 44.1 kHz
+    static constexpr size_t MIN_FRAMES_PER_WORKER = 256;     // Keeps priming overhead ~1%
+    static constexpr size_t DECODE_CHUNK_FRAMES = 1 << 18;   // Progress/cancel granularity, ~230 MP3 frames
+
+    bool mapFile(const std::string& filename);
+    bool decodeMP3();
+    bool decodeSlice(size_t begin, size_t end); // False if its scratch block could not be allocated
+    bool isLoadCancelled() const { return load_cancel && load_cancel->load(); }
+    bool loadCachedMP3();
+    void startCacheWrite();
+    void stopCacheWrite();
+    bool loadWAV();
+    bool buildIndex();
+    void startStreamThread(size_t position);
+    void stopStreamThread();
+    void streamProducer();
+    void resetMad();
     void cleanup();
+
+    // Per-channel write pointers into samples at the given frame
+    std::array<float*, MAX_CHANNELS> channelPointers(size_t position);
+
+    // Synthesized PCM for an output channel
+    static const mad_fixed_t* pcmChannel(const struct mad_pcm& pcm, unsigned int ch);
+
+    // Convert one synthesized PCM channel to float in [-1, 1] (SIMD)
+    static void convertPCM(const mad_fixed_t* in, float* out, unsigned int count);
 };
 
 #endif // AUDIODECODER_H
-
@@ -3,6 +3,9 @@
 #include <cstdint>
 #include <fstream>
 #include <algorithm>
+#include <vector>
+#include <cstring>
+#include "SimdKernels.h"
 
 namespace {
 
@@ -22,13 +25,29 @@ inline void writeLE32(std::ofstream& out, std::uint32_t value) {
     out.write(bytes, 4);
 }
 
+// Frames converted per write() call
+constexpr std::size_t EXPORT_BLOCK_FRAMES = 4096;
+
 } // namespace
 
 bool AudioExporter::exportToWav(const std::string& path,
-                                const std::vector<float>& samples,
+                                const SampleBuffer& samples,
+                                unsigned int sampleRate) {
+    return exportToWav(path, samples.getChannels(), samples.getFrames(), sampleRate,
+                       [&samples](size_t start, size_t count, float* const* out) {
+        for (unsigned int ch = 0; ch < samples.getChannels(); ++ch) {
+            memcpy(out[ch], samples.channel(ch) + start, count * sizeof(float));
+        }
+        return count;
+    });
+}
+
+bool AudioExporter::exportToWav(const std::string& path,
+                                unsigned int channels,
+                                size_t frames,
                                 unsigned int sampleRate,
-                                unsigned int channels) {
-    if (samples.empty() || sampleRate == 0 || channels == 0) {
+                                const BlockReader& reader) {
+    if (frames == 0 || sampleRate == 0 || channels == 0) {
         return false;
     }
 
@@ -37,9 +56,8 @@ bool AudioExporter::exportToWav(const std::string& path,
         return false;
     }
 
-    // We treat input as mono PCM; if channels > 1 we duplicate samples.
-    std::uint32_t numInputSamples = static_cast<std::uint32_t>(samples.size());
-    std::uint32_t totalSamples = numInputSamples * channels;
+    std::uint32_t numFrames = static_cast<std::uint32_t>(frames);
+    std::uint32_t totalSamples = numFrames * channels;
     std::uint32_t bytesPerSample = sizeof(std::int16_t);
     std::uint32_t dataChunkSize = totalSamples * bytesPerSample;
     std::uint32_t riffChunkSize = 36 + dataChunkSize;
@@ -65,15 +83,40 @@ bool AudioExporter::exportToWav(const std::string& path,
     out.write("data", 4);
     writeLE32(out, dataChunkSize);
 
-    // Write samples
-    for (std::uint32_t i = 0; i < numInputSamples; ++i) {
-        // Clamp float sample to [-1, 1] and convert to int16
-        float s = std::max(-1.0f, std::min(1.0f, samples[i]));
-        std::int16_t value = static_cast<std::int16_t>(s * 32767.0f);
+    // Write samples a block at a time: each channel is pulled from the
+    // reader, converted with SIMD and interleaved into little-endian bytes
+    SampleBuffer floats;
+    if (!floats.allocate(channels, EXPORT_BLOCK_FRAMES)) {
+        return false;
+    }
+    std::vector<float*> floatChannels;
+    for (unsigned int ch = 0; ch < channels; ++ch) {
+        floatChannels.push_back(floats.channel(ch));
+    }
+    std::vector<std::int16_t> converted(EXPORT_BLOCK_FRAMES);
+    std::vector<char> block(EXPORT_BLOCK_FRAMES * channels * bytesPerSample);
+    for (std::uint32_t start = 0; start < numFrames; start += EXPORT_BLOCK_FRAMES) {
+        std::uint32_t count = std::min<std::uint32_t>(EXPORT_BLOCK_FRAMES, numFrames - start);
+        std::uint32_t got = std::min<std::uint32_t>(count, static_cast<std::uint32_t>(
+            reader(start, count, floatChannels.data())));
+        for (unsigned int ch = 0; ch < channels; ++ch) {
+            // Frames the reader could not supply are written as silence
+            std::fill(floatChannels[ch] + got, floatChannels[ch] + count, 0.0f);
+        }
 
         for (unsigned int ch = 0; ch < channels; ++ch) {
-            writeLE16(out, static_cast<std::uint16_t>(value));
+            // Saturates to int16, which also clamps the float sample to [-1, 1]
+            SimdKernels::floatToInt16(floatChannels[ch], converted.data(), count, 32767.0f);
+            char* dst = &block[ch * bytesPerSample];
+            for (std::uint32_t i = 0; i < count; ++i) {
+                std::uint16_t value = static_cast<std::uint16_t>(converted[i]);
+                dst[0] = static_cast<char>(value & 0xFF);
+                dst[1] = static_cast<char>((value >> 8) & 0xFF);
+                dst += channels * bytesPerSample;
+            }
         }
+
+        out.write(block.data(), count * channels * bytesPerSample);
     }
 
     out.close();
@@ -2,17 +2,28 @@
 #define AUDIOEXPORTER_H
 
 #include <string>
-#include <vector>
+#include <functional>
+#include "SampleBuffer.h"
 
 class AudioExporter {
 public:
-    // Export floating-point PCM samples in [-1, 1] to a 16-bit PCM WAV file.
-    // Channels controls how many channels to write; if channels > 1 and the
-    // samples are mono, they will be duplicated across channels.
+    // Fills one float array per channel with count frames starting at start
+    // and returns how many frames it produced
+    using BlockReader = std::function<size_t(size_t start, size_t count, float* const* out)>;
+
+    // Export planar floating-point PCM samples in [-1, 1] to an interleaved
+    // 16-bit PCM WAV file with one WAV channel per buffer channel.
+    static bool exportToWav(const std::string& path,
+                            const SampleBuffer& samples,
+                            unsigned int sampleRate);
+
+    // Same, pulling frames from reader a block at a time so the full track
+    // never has to exist as float (e.g. compact or filtered-on-the-fly sources)
     static bool exportToWav(const std::string& path,
-                            const std::vector<float>& samples,
+                            unsigned int channels,
+                            size_t frames,
                             unsigned int sampleRate,
-                            unsigned int channels);
+                            const BlockReader& reader);
 };
 
 #endif // AUDIOEXPORTER_H
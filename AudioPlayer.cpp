@@ -1,18 +1,52 @@
 #include "AudioPlayer.h"
+#include "FFTPlanCache.h"
 #include <iostream>
 #include <cstring>
 #include <QMutexLocker>
 
 AudioPlayer::AudioPlayer(QObject* parent)
-    : QObject(parent), stream(nullptr), playing(false), paused(false), current_position(0) {
+    : QObject(parent), sample_storage(AudioDecoder::SampleStorage::Float32),
+      analysis_mode(AnalysisMode::FFT), hop_size(DEFAULT_HOP_SIZE),
+      stream(nullptr), playing(false), paused(false), current_position(0),
+      display_delay(DISPLAY_DELAY_FRAMES), display_delay_pos(0),
+      live_mode(AnalysisMode::FFT), live_fresh(false),
+      load_cancel(false), load_generation(0), loading(false),
+      spectrogram_ready(false), spectrogram_cancel(false), spectrogram_generation(0),
+      display_timer(nullptr) {
+    decoder = createDecoder();
+    fft_analyzer.setWindow(FFTAnalyzer::WindowType::Hann);
+    fft_analyzer.setHopSize(hop_size);
+    multi_analyzer.setWindow(FFTAnalyzer::WindowType::Hann);
+    multi_analyzer.setHopSize(hop_size);
+    cq_analyzer.setHopSize(hop_size);
+    live_spectrum.reserve(FFTAnalyzer::MAX_FFT_SIZE / 2 + 1);
+    
+    // Shows spectrogram rows during playback, or else the live analyzers'
+    // latest spectrum: however short the hop, the display updates once per
+    // interval
+    display_timer = new QTimer(this);
+    display_timer->setInterval(DISPLAY_INTERVAL_MS);
+    connect(display_timer, &QTimer::timeout, this, [this]() {
+        if (!playing || paused) {
+            return;
+        }
+        if (hasSpectrogram()) {
+            showSpectrumAt(displayPosition());
+        } else {
+            showLiveSpectrum();
+        }
+    });
     if (!initializePortAudio()) {
         std::cerr << "Failed to initialize PortAudio" << std::endl;
     }
 }
 
 AudioPlayer::~AudioPlayer() {
-    stopPlayback();
+    cancelLoad();
+    cancelSpectrogram();
+    haltPlayback();
     cleanupPortAudio();
+    FFTPlanCache::saveWisdom();
 }
 
 bool AudioPlayer::initializePortAudio() {
@@ -32,19 +66,118 @@ void AudioPlayer::cleanupPortAudio() {
     Pa_Terminate();
 }
 
-bool AudioPlayer::loadFile(const std::string& filename) {
-    // Ensure any existing playback is stopped and state reset
-    stopPlayback();
-    current_position = 0;
-    bool ok = decoder.loadFile(filename);
+std::unique_ptr<AudioDecoder> AudioPlayer::createDecoder() {
+    std::unique_ptr<AudioDecoder> fresh(new AudioDecoder());
+    fresh->setCache(&pcm_cache);
+    fresh->setSampleStorage(sample_storage);
+    return fresh;
+}
+
+bool AudioPlayer::loadFile(const std::string& filename, bool streaming) {
+    cancelLoad();
+    std::unique_ptr<AudioDecoder> fresh = createDecoder();
+    bool ok = streaming ? fresh->openStream(filename) : fresh->loadFile(filename);
     if (!ok) {
         std::cerr << "Failed to decode audio file: " << filename << std::endl;
+        return false;
+    }
+    installDecoder(std::move(fresh));
+    return true;
+}
+
+void AudioPlayer::loadFileAsync(const std::string& filename, bool streaming) {
+    cancelLoad();
+    load_cancel.store(false);
+    loading = true;
+    unsigned int generation = ++load_generation;
+
+    load_thread = std::thread([this, filename, streaming, generation]() {
+        std::unique_ptr<AudioDecoder> fresh = createDecoder();
+        AudioDecoder* target = fresh.get();
+        fresh->setCancelFlag(&load_cancel);
+        fresh->setProgressCallback([this, target](size_t decodedFrames, size_t totalFrames) {
+            // Called from the decode workers; the signal is queued to the GUI thread
+            double rate = target->getSampleRate();
+            emit loadProgress(decodedFrames / rate, totalFrames / rate);
+        });
+
+        bool ok = streaming ? fresh->openStream(filename) : fresh->loadFile(filename);
+        fresh->setProgressCallback(nullptr);
+        fresh->setCancelFlag(nullptr);
+        if (!ok && !load_cancel.load()) {
+            std::cerr << "Failed to decode audio file: " << filename << std::endl;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending_decoder = ok ? std::move(fresh) : nullptr;
+        }
+        QMetaObject::invokeMethod(this, [this, generation, ok]() {
+            finishLoad(generation, ok);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AudioPlayer::cancelLoad() {
+    load_cancel.store(true);
+    if (load_thread.joinable()) {
+        load_thread.join();
+    }
+    load_generation++; // Ignore the finishLoad it may have queued
+    loading = false;
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    pending_decoder.reset();
+}
+
+void AudioPlayer::finishLoad(unsigned int generation, bool ok) {
+    if (generation != load_generation) {
+        return;
+    }
+    if (load_thread.joinable()) {
+        load_thread.join();
+    }
+    loading = false;
+
+    std::unique_ptr<AudioDecoder> fresh;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        fresh = std::move(pending_decoder);
     }
-    return ok;
+    if (ok && fresh) {
+        installDecoder(std::move(fresh));
+    }
+    emit loadFinished(ok && decoder->isLoaded());
+}
+
+void AudioPlayer::installDecoder(std::unique_ptr<AudioDecoder> fresh) {
+    // The audio callback and the spectrogram workers are the only other
+    // users of decoder, so once both are stopped the swap cannot be observed
+    // half-done. The outgoing decoder is not rewound: it is about to go.
+    haltPlayback();
+    cancelSpectrogram();
+    current_position = 0;
+    decoder = std::move(fresh);
+    
+    // Preallocate the callback's scratch blocks so it never allocates
+    render_block.clear();
+    render_channels.clear();
+    stream_block.clear();
+    unsigned int channels = decoder->getChannels();
+    render_block.allocate(channels, RENDER_BLOCK_FRAMES);
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        render_channels.push_back(render_block.channel(ch));
+    }
+    if (decoder->isStreaming()) {
+        stream_block.resize(RENDER_BLOCK_FRAMES * channels);
+    }
+    
+    configureAnalyzers();
+    startSpectrogram();
 }
 
 bool AudioPlayer::startPlayback() {
-    if (!decoder.isLoaded()) {
+    if (!decoder->isLoaded()) {
         std::cerr << "No file loaded" << std::endl;
         return false;
     }
@@ -59,13 +192,18 @@ bool AudioPlayer::startPlayback() {
     }
     
     // Reset position if at end
-    if (current_position >= decoder.getSamples().size()) {
+    if (decoder->isStreaming()) {
+        if (decoder->isStreamFinished()) {
+            decoder->rewindStream();
+            current_position = 0;
+        }
+    } else if (current_position >= decoder->getLength()) {
         current_position = 0;
     }
     
     // Get audio parameters
-    unsigned int sample_rate = decoder.getSampleRate();
-    unsigned int channels = decoder.getChannels();
+    unsigned int sample_rate = decoder->getSampleRate();
+    unsigned int channels = decoder->getChannels();
     
     // Configure PortAudio stream
     PaStreamParameters outputParameters;
@@ -99,7 +237,11 @@ bool AudioPlayer::startPlayback() {
     
     // Reset FFT analyzer and filter
     fft_analyzer.reset();
-    frequency_filter.reset();
+    {
+        QMutexLocker locker(&filter_mutex);
+        frequency_filter.setChannelCount(channels);
+        frequency_filter.reset();
+    }
     
     // Update filter sample rate
     frequency_filter.setLowPassCutoff(0, sample_rate);
@@ -116,20 +258,28 @@ bool AudioPlayer::startPlayback() {
     
     playing = true;
     paused = false;
+    display_timer->start();
     return true;
 }
 
 void AudioPlayer::stopPlayback() {
+    haltPlayback();
+    decoder->rewindStream();
+}
+
+void AudioPlayer::haltPlayback() {
     if (stream) {
         Pa_StopStream(stream);
         Pa_CloseStream(stream);
         stream = nullptr;
     }
+    display_timer->stop();
     playing = false;
     paused = false;
     current_position = 0;
     fft_analyzer.reset();
     frequency_filter.reset();
+    std::fill(display_delay.begin(), display_delay.end(), 0.0f);
 }
 
 void AudioPlayer::pausePlayback() {
@@ -137,6 +287,7 @@ void AudioPlayer::pausePlayback() {
         PaError err = Pa_StopStream(stream);
         if (err == paNoError) {
             paused = true;
+            display_timer->stop();
         }
     }
 }
@@ -146,12 +297,47 @@ void AudioPlayer::resumePlayback() {
         PaError err = Pa_StartStream(stream);
         if (err == paNoError) {
             paused = false;
+            display_timer->start();
         } else {
             std::cerr << "Failed to resume playback: " << Pa_GetErrorText(err) << std::endl;
         }
     }
 }
 
+void AudioPlayer::seek(size_t position) {
+    if (!decoder->isLoaded()) {
+        return;
+    }
+    position = std::min(position, decoder->getLength());
+    
+    // Hold the callback off while the stream is repositioned
+    bool running = playing && !paused && stream;
+    if (running) {
+        Pa_StopStream(stream);
+    }
+    
+    decoder->seekStream(position);
+    current_position = position;
+    fft_analyzer.reset();
+    multi_analyzer.reset();
+    cq_analyzer.reset();
+    std::fill(display_delay.begin(), display_delay.end(), 0.0f);
+    {
+        QMutexLocker locker(&live_mutex);
+        live_fresh = false;
+    }
+    frequency_filter.reset();
+    showSpectrumAt(position);
+    
+    if (running) {
+        PaError err = Pa_StartStream(stream);
+        if (err != paNoError) {
+            std::cerr << "Failed to restart playback after seek: " << Pa_GetErrorText(err) << std::endl;
+            playing = false;
+        }
+    }
+}
+
 int AudioPlayer::audioCallback(const void* input, void* output,
                                unsigned long frameCount,
                                const PaStreamCallbackTimeInfo* timeInfo,
@@ -164,51 +350,75 @@ int AudioPlayer::audioCallback(const void* input, void* output,
 int AudioPlayer::processAudio(const void* input, void* output, unsigned long frameCount) {
     (void)input; // Unused
     
-    if (!decoder.isLoaded()) {
-        memset(output, 0, frameCount * decoder.getChannels() * sizeof(float));
+    if (!decoder->isLoaded()) {
+        memset(output, 0, frameCount * decoder->getChannels() * sizeof(float));
         return paComplete;
     }
     
-    const std::vector<float>& samples = decoder.getSamples();
     float* out = (float*)output;
-    unsigned int channels = decoder.getChannels();
+    unsigned int channels = decoder->getChannels();
+    
+    if (decoder->isStreaming()) {
+        // Pull whatever the background decoder has produced so far
+        size_t frames_done = 0;
+        while (frames_done < frameCount) {
+            size_t want = std::min((size_t)frameCount - frames_done, RENDER_BLOCK_FRAMES);
+            size_t got = decoder->readStream(stream_block.data(), want);
+            if (got == 0) {
+                break;
+            }
+            
+            // Deinterleave so rendering sees the same planar layout as readFrames
+            for (unsigned int ch = 0; ch < channels; ch++) {
+                float* dst = render_channels[ch];
+                for (size_t i = 0; i < got; i++) {
+                    dst[i] = stream_block[i * channels + ch];
+                }
+            }
+            renderSamples(render_channels.data(), got, &out[frames_done * channels], channels);
+            frames_done += got;
+        }
+        
+        if (frames_done == 0 && decoder->isStreamFinished()) {
+            memset(output, 0, frameCount * channels * sizeof(float));
+            playing = false;
+            emit playbackFinished();
+            return paComplete;
+        }
+        
+        // Output silence on underrun rather than stalling the callback
+        if (frames_done < frameCount) {
+            memset(&out[frames_done * channels], 0,
+                   (frameCount - frames_done) * channels * sizeof(float));
+        }
+        
+        current_position += frames_done;
+        return paContinue;
+    }
+    
+    size_t total = decoder->getLength();
     
     // Check if we've reached the end
-    if (current_position >= samples.size()) {
+    if (current_position >= total) {
         memset(output, 0, frameCount * channels * sizeof(float));
         playing = false;
         emit playbackFinished();
         return paComplete;
     }
     
-    // Copy samples to output buffer
-    size_t samples_to_copy = std::min((size_t)frameCount, samples.size() - current_position);
-    
-    // Get sample rate for filter/visualization
-    unsigned int sample_rate = decoder.getSampleRate();
+    // Copy samples to output buffer a block at a time (WAV converts here)
+    size_t samples_to_copy = std::min((size_t)frameCount, total - current_position);
     
-    for (size_t i = 0; i < samples_to_copy; i++) {
-        float sample = samples[current_position + i];
-
-        // Feed original sample to FFT analyzer (for visualization)
-        if (fft_analyzer.addSample(sample)) {
-            std::vector<float> magnitudes = fft_analyzer.getMagnitudes();
-            if (!magnitudes.empty()) {
-                QMutexLocker locker(&filter_mutex);
-                // Apply current filter settings to visualization magnitudes
-                frequency_filter.processFFT(magnitudes, sample_rate);
-            }
-            emit fftDataReady(magnitudes);
-        }
-
-        // Apply FIR filter in time-domain for audio
-        QMutexLocker locker(&filter_mutex);
-        float filtered_sample = frequency_filter.processSample(sample);
-
-        // Output filtered sample to all channels (mono or stereo)
-        for (unsigned int ch = 0; ch < channels; ch++) {
-            out[i * channels + ch] = filtered_sample;
+    for (size_t done = 0; done < samples_to_copy; ) {
+        size_t got = decoder->readFrames(current_position + done,
+                                        std::min(samples_to_copy - done, RENDER_BLOCK_FRAMES),
+                                        render_channels.data());
+        if (got == 0) {
+            samples_to_copy = done;
+            break;
         }
+        renderSamples(render_channels.data(), got, &out[done * channels], channels);
+        done += got;
     }
     
     // Zero out remaining frames if we've reached the end
@@ -222,46 +432,350 @@ int AudioPlayer::processAudio(const void* input, void* output, unsigned long fra
     return paContinue;
 }
 
+void AudioPlayer::renderSamples(float* const* samples, size_t count, float* out, unsigned int channels) {
+    float mix_scale = 1.0f / channels;
+    
+    // With the spectrogram in place the display timer shows its rows, so the
+    // callback does no FFT work at all. The other modes are always live.
+    // The analyzers are only tried: while their settings are being changed
+    // this block goes unanalyzed rather than making the callback wait.
+    AnalysisMode mode = analysis_mode.load();
+    bool live = mode != AnalysisMode::FFT || !spectrogram_ready.load(std::memory_order_acquire);
+    bool analyze = live && analyzer_mutex.tryLock();
+    
+    // Feed the mono mix of the original samples to the analyzer (for
+    // visualization) as late as the filter delays it, and leave only its
+    // latest spectrum for the display. The delay line is kept up to date
+    // even when this block goes unanalyzed.
+    const size_t mask = DISPLAY_DELAY_FRAMES - 1;
+    const size_t delay = std::min(frequency_filter.getDelay(), mask);
+    const std::vector<float>* latest = nullptr;
+    for (size_t i = 0; live && i < count; i++) {
+        float sample = 0.0f;
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            sample += samples[ch][i];
+        }
+        size_t at = display_delay_pos++ & mask;
+        display_delay[at] = sample * mix_scale;
+        if (!analyze) {
+            continue;
+        }
+        if (const std::vector<float>* magnitudes = analyzeSample(mode, display_delay[(at - delay) & mask])) {
+            latest = magnitudes;
+        }
+    }
+    if (latest && latest->size() <= live_spectrum.capacity() && live_mutex.tryLock()) {
+        live_spectrum.assign(latest->begin(), latest->end());
+        live_mode = mode;
+        live_fresh = true;
+        live_mutex.unlock();
+    }
+    if (analyze) {
+        analyzer_mutex.unlock();
+    }
+    
+    // Apply FIR filter in time-domain for audio, each channel separately,
+    // then interleave. Lock-free: filter changes are picked up per block.
+    frequency_filter.processChannels(samples, channels, count);
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        const float* data = samples[ch];
+        for (size_t i = 0; i < count; i++) {
+            out[i * channels + ch] = data[i];
+        }
+    }
+}
+
+const std::vector<float>* AudioPlayer::analyzeSample(AnalysisMode mode, float sample) {
+    switch (mode) {
+    case AnalysisMode::FFT:
+        return fft_analyzer.addSample(sample) ? &fft_analyzer.getMagnitudes() : nullptr;
+    case AnalysisMode::MultiResolution:
+        return multi_analyzer.addSample(sample) ? &multi_analyzer.getMagnitudes() : nullptr;
+    case AnalysisMode::ConstantQ:
+        return cq_analyzer.addSample(sample) ? &cq_analyzer.getMagnitudes() : nullptr;
+    }
+    return nullptr;
+}
+
+void AudioPlayer::showLiveSpectrum() {
+    std::vector<float> magnitudes;
+    AnalysisMode mode;
+    {
+        QMutexLocker locker(&live_mutex);
+        if (!live_fresh) {
+            return;
+        }
+        magnitudes = live_spectrum;
+        mode = live_mode;
+        live_fresh = false;
+    }
+    if (mode != analysis_mode.load()) {
+        return; // From before a mode change
+    }
+    
+    // Apply current filter settings to visualization magnitudes (the
+    // analyzers are only swapped on this thread, so their bins are current)
+    if (mode == AnalysisMode::ConstantQ) {
+        frequency_filter.processBands(magnitudes, cq_analyzer.getFrequencies());
+    } else {
+        frequency_filter.processFFT(magnitudes, decoder->getSampleRate());
+    }
+    emit fftDataReady(magnitudes);
+}
+
+bool AudioPlayer::setFFTSize(int size) {
+    // Plan before taking the lock the audio callback needs
+    FFTAnalyzer::prepare(size);
+    {
+        QMutexLocker locker(&analyzer_mutex);
+        if (!fft_analyzer.setFFTSize(size)) {
+            return false;
+        }
+    }
+    startSpectrogram();
+    return true;
+}
+
+void AudioPlayer::setHopSize(int hop) {
+    {
+        QMutexLocker locker(&analyzer_mutex);
+        hop_size = hop;
+        fft_analyzer.setHopSize(hop);
+        multi_analyzer.setHopSize(hop);
+        cq_analyzer.setHopSize(hop);
+    }
+    startSpectrogram();
+}
+
+void AudioPlayer::setAnalysisWindow(FFTAnalyzer::WindowType type) {
+    {
+        QMutexLocker locker(&analyzer_mutex);
+        fft_analyzer.setWindow(type);
+        multi_analyzer.setWindow(type);
+    }
+    startSpectrogram();
+}
+
+void AudioPlayer::setAnalysisMode(AnalysisMode mode) {
+    {
+        QMutexLocker locker(&analyzer_mutex);
+        analysis_mode.store(mode);
+        multi_analyzer.reset();
+        cq_analyzer.reset();
+    }
+    configureAnalyzers();
+    startSpectrogram();
+}
+
+void AudioPlayer::configureAnalyzers() {
+    unsigned int rate = getSampleRate();
+    AnalysisMode mode = analysis_mode.load();
+    if (rate == 0) {
+        return;
+    }
+    
+    if (mode == AnalysisMode::MultiResolution && rate != multi_analyzer.getSampleRate()) {
+        // Like the constant-Q analyzer below: set up without the lock the
+        // audio callback needs, swapped in under it
+        MultiResolutionAnalyzer configured;
+        configured.setWindow(multi_analyzer.getWindow());
+        configured.setHopSize(hop_size);
+        if (configured.configure(MultiResolutionAnalyzer::defaultLayout(), rate)) {
+            QMutexLocker locker(&analyzer_mutex);
+            multi_analyzer.swap(configured);
+        }
+    }
+    
+    if (mode == AnalysisMode::ConstantQ && rate != cq_analyzer.getSampleRate()) {
+        // Configure a new analyzer (kernel, FFT plan and buffers) without
+        // the lock the audio callback needs, then only swap it in; the old
+        // one is freed after the lock is released
+        ConstantQAnalyzer configured;
+        configured.setHopSize(hop_size);
+        configured.setSpectrumScale(cq_analyzer.getSpectrumScale());
+        if (!configured.configure(rate)) {
+            std::cerr << "Constant-Q analysis is not available at " << rate << " Hz" << std::endl;
+            return;
+        }
+        QMutexLocker locker(&analyzer_mutex);
+        cq_analyzer.swap(configured);
+    }
+}
+
+void AudioPlayer::startSpectrogram() {
+    cancelSpectrogram();
+    if (!decoder->isLoaded() || decoder->isStreaming() || analysis_mode.load() != AnalysisMode::FFT) {
+        return; // Streams and the other modes keep using the live analyzers
+    }
+
+    spectrogram_cancel.store(false);
+    unsigned int generation = ++spectrogram_generation;
+    const AudioDecoder* source = decoder.get();
+    int size = fft_analyzer.getFFTSize();
+    int hop = fft_analyzer.getHopSize();
+    FFTAnalyzer::WindowType window = fft_analyzer.getWindow();
+
+    spectrogram_thread = std::thread([this, source, size, hop, window, generation]() {
+        std::shared_ptr<Spectrogram> result = std::make_shared<Spectrogram>();
+        if (!result->compute(*source, size, hop, window, 0, &spectrogram_cancel)) {
+            return; // Cancelled (or out of memory); the live analyzer stays on
+        }
+        QMetaObject::invokeMethod(this, [this, generation, result]() {
+            finishSpectrogram(generation, result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void AudioPlayer::cancelSpectrogram() {
+    spectrogram_cancel.store(true);
+    if (spectrogram_thread.joinable()) {
+        spectrogram_thread.join();
+    }
+    spectrogram_generation++; // Ignore the finishSpectrogram it may have queued
+    
+    // Hand visuals back to the callback before the table goes away; the
+    // analyzer restarts from an empty buffer
+    {
+        QMutexLocker locker(&analyzer_mutex);
+        fft_analyzer.reset();
+        spectrogram_ready.store(false, std::memory_order_release);
+    }
+    spectrogram.reset();
+}
+
+void AudioPlayer::finishSpectrogram(unsigned int generation, std::shared_ptr<const Spectrogram> result) {
+    if (generation != spectrogram_generation) {
+        return;
+    }
+    if (spectrogram_thread.joinable()) {
+        spectrogram_thread.join();
+    }
+    spectrogram = result;
+    spectrogram_ready.store(true, std::memory_order_release);
+    showSpectrumAt(current_position);
+}
+
+size_t AudioPlayer::displayPosition() const {
+    size_t delay = frequency_filter.getDelay();
+    return (current_position > delay) ? current_position - delay : 0;
+}
+
+void AudioPlayer::showSpectrumAt(size_t position) {
+    if (!spectrogram_ready.load(std::memory_order_acquire) || !spectrogram) {
+        return;
+    }
+    const float* row = spectrogram->frameAtPosition(position);
+    if (!row) {
+        return;
+    }
+    std::vector<float> magnitudes(row, row + spectrogram->getBins());
+    frequency_filter.processFFT(magnitudes, decoder->getSampleRate());
+    emit fftDataReady(magnitudes);
+}
+
 bool AudioPlayer::exportEditedToWav(const std::string& path) {
-    if (!decoder.isLoaded()) {
+    if (!decoder->isLoaded()) {
         std::cerr << "Cannot export: no file loaded\n";
         return false;
     }
 
-    const std::vector<float>& samples = decoder.getSamples();
-    if (samples.empty()) {
+    const AudioDecoder& source = *decoder;
+    size_t frames = source.getLength();
+    if (frames == 0) {
         std::cerr << "Cannot export: decoder has no samples\n";
         return false;
     }
 
-    unsigned int sampleRate = decoder.getSampleRate();
+    unsigned int sampleRate = decoder->getSampleRate();
     if (sampleRate == 0) {
         std::cerr << "Cannot export: invalid sample rate\n";
         return false;
     }
 
-    // Copy current filter configuration under mutex
-    FrequencyFilter exportFilter;
-    {
-        QMutexLocker locker(&filter_mutex);
-        exportFilter = frequency_filter; // copy coefficients and flags
+    // Copy current filter configuration under mutex; the copy gets fresh
+    // delay lines, so export does not depend on playback state
+    QMutexLocker locker(&filter_mutex);
+    FrequencyFilter exportFilter(frequency_filter);
+    locker.unlock();
+    unsigned int channels = source.getChannels();
+    exportFilter.setChannelCount(channels);
+
+    // Streaming mode only keeps a window of the track in memory, so the
+    // export decodes the file itself, at full precision (MP3 overs keep
+    // their headroom for the filter). Each decodeRange call re-primes
+    // libmad, so it decodes EXPORT_DECODE_FRAMES at a time and the
+    // exporter's smaller, sequential reads are served from that.
+    SampleBuffer decoded;
+    std::vector<float*> decodedChannels;
+    size_t decodedStart = 0;
+    size_t decodedFrames = 0;
+    if (source.isStreaming()) {
+        if (!decoded.allocate(channels, EXPORT_DECODE_FRAMES)) {
+            std::cerr << "Cannot export: out of memory\n";
+            return false;
+        }
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            decodedChannels.push_back(decoded.channel(ch));
+        }
     }
-    // Use fresh delay lines for export so we don't depend on playback state
-    exportFilter.reset();
+    auto readSource = [&](size_t start, size_t count, float* const* out) -> size_t {
+        if (!source.isStreaming()) {
+            return source.readFrames(start, count, out);
+        }
+        size_t done = 0;
+        while (done < count) {
+            size_t pos = start + done;
+            if (pos < decodedStart || pos >= decodedStart + decodedFrames) {
+                decodedStart = pos;
+                decodedFrames = source.decodeRange(pos, EXPORT_DECODE_FRAMES, decodedChannels.data());
+                if (decodedFrames == 0) {
+                    break;
+                }
+            }
+            size_t n = std::min(count - done, decodedStart + decodedFrames - pos);
+            for (unsigned int ch = 0; ch < channels; ch++) {
+                std::memcpy(out[ch] + done, decodedChannels[ch] + (pos - decodedStart), n * sizeof(float));
+            }
+            done += n;
+        }
+        return done;
+    };
 
-    std::vector<float> filtered(samples.size(), 0.0f);
-    for (size_t i = 0; i < samples.size(); ++i) {
-        filtered[i] = exportFilter.processSample(samples[i]);
+    // The filter lags its input by overlap-save's block and the FIRs' group
+    // delay, which an offline render has no need for: run it that far ahead
+    // of the output, on silence past the end so the tail is flushed out
+    const size_t latency = exportFilter.getDelay();
+    auto readFiltered = [&](size_t start, size_t count, float* const* out) {
+        size_t got = readSource(start, count, out);
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            std::fill(out[ch] + got, out[ch] + count, 0.0f);
+        }
+        exportFilter.processChannels(out, channels, count);
+    };
+    if (latency > 0) {
+        SampleBuffer lead;
+        if (!lead.allocate(channels, latency)) {
+            std::cerr << "Cannot export: out of memory\n";
+            return false;
+        }
+        std::vector<float*> leadChannels;
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            leadChannels.push_back(lead.channel(ch));
+        }
+        readFiltered(0, latency, leadChannels.data());
     }
 
-    // For safety, export as mono even if original was stereo (samples are mono)
-    unsigned int channels = 1;
-    return AudioExporter::exportToWav(path, filtered, sampleRate, channels);
+    // Read (or expand) and filter one block at a time as the exporter asks for it
+    return AudioExporter::exportToWav(path, channels, frames, sampleRate,
+                                      [&](size_t start, size_t count, float* const* out) {
+        readFiltered(start + latency, count, out);
+        return count;
+    });
 }
 
 void AudioPlayer::setLowPassCutoff(float cutoffHz) {
     QMutexLocker locker(&filter_mutex);
-    unsigned int sample_rate = decoder.getSampleRate();
+    unsigned int sample_rate = decoder->getSampleRate();
     if (sample_rate > 0) {
         frequency_filter.setLowPassCutoff(cutoffHz, sample_rate);
     }
@@ -269,7 +783,7 @@ void AudioPlayer::setLowPassCutoff(float cutoffHz) {
 
 void AudioPlayer::setHighPassCutoff(float cutoffHz) {
     QMutexLocker locker(&filter_mutex);
-    unsigned int sample_rate = decoder.getSampleRate();
+    unsigned int sample_rate = decoder->getSampleRate();
     if (sample_rate > 0) {
         frequency_filter.setHighPassCutoff(cutoffHz, sample_rate);
     }
@@ -277,7 +791,7 @@ void AudioPlayer::setHighPassCutoff(float cutoffHz) {
 
 void AudioPlayer::setBandStop(float lowHz, float highHz) {
     QMutexLocker locker(&filter_mutex);
-    unsigned int sample_rate = decoder.getSampleRate();
+    unsigned int sample_rate = decoder->getSampleRate();
     if (sample_rate > 0) {
         frequency_filter.setBandStop(lowHz, highHz, sample_rate);
     }
@@ -285,7 +799,7 @@ void AudioPlayer::setBandStop(float lowHz, float highHz) {
 
 void AudioPlayer::setBandPass(float lowHz, float highHz) {
     QMutexLocker locker(&filter_mutex);
-    unsigned int sample_rate = decoder.getSampleRate();
+    unsigned int sample_rate = decoder->getSampleRate();
     if (sample_rate > 0) {
         frequency_filter.setBandPass(lowHz, highHz, sample_rate);
     }
@@ -311,3 +825,7 @@ void AudioPlayer::enableBandPass(bool enabled) {
     frequency_filter.enableBandPass(enabled);
 }
 
+void AudioPlayer::setFilterBackend(FrequencyFilter::Backend backend, BiquadCascade::Response response) {
+    QMutexLocker locker(&filter_mutex);
+    frequency_filter.setBackend(backend, response);
+}
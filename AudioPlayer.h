@@ -5,10 +5,18 @@
 #include <QThread>
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <portaudio.h>
 #include <QMutex>
+#include <QTimer>
 #include "AudioDecoder.h"
 #include "FFTAnalyzer.h"
+#include "ConstantQAnalyzer.h"
+#include "MultiResolutionAnalyzer.h"
+#include "Spectrogram.h"
 #include "FrequencyFilter.h"
 #include "AudioExporter.h"
 
@@ -19,8 +27,23 @@ public:
     AudioPlayer(QObject* parent = nullptr);
     ~AudioPlayer();
     
-    // Load audio file
-    bool loadFile(const std::string& filename);
+    // Load audio file. In streaming mode the file is decoded in the background
+    // during playback instead of up front.
+    bool loadFile(const std::string& filename, bool streaming = false);
+
+    // Load audio file on a worker thread. The current file stays loaded (and
+    // keeps playing) meanwhile; loadProgress is emitted while decoding and
+    // loadFinished once the new decoder has been swapped in or failed.
+    void loadFileAsync(const std::string& filename, bool streaming = false);
+
+    // Abandon a running loadFileAsync; no loadFinished is emitted for it
+    void cancelLoad();
+
+    // Check if a loadFileAsync is in progress
+    bool isLoading() const { return loading; }
+
+    // Sample storage for subsequent non-streaming loads (see AudioDecoder)
+    void setSampleStorage(AudioDecoder::SampleStorage storage) { sample_storage = storage; }
     
     // Playback control
     bool startPlayback();
@@ -35,11 +58,48 @@ public:
     // Get current position (in samples)
     size_t getCurrentPosition() const { return current_position; }
     
+    // Jump to a position (in samples); streaming mode uses the frame index
+    void seek(size_t position);
+
+    // Emit fftDataReady with the precomputed spectrum at a position (in
+    // samples), e.g. while scrubbing. Does nothing until the spectrogram for
+    // the current file and analysis settings is ready.
+    void showSpectrumAt(size_t position);
+    bool hasSpectrogram() const { return spectrogram_ready.load(); }
+    
     // Get total length (in samples)
-    size_t getTotalLength() const { return decoder.isLoaded() ? decoder.getSamples().size() : 0; }
+    size_t getTotalLength() const { return decoder->isLoaded() ? decoder->getLength() : 0; }
+    
+    // Analysis FFT size (FFTAnalyzer::MIN_FFT_SIZE..MAX_FFT_SIZE); larger
+    // sizes resolve finer frequencies but update the display less often
+    bool setFFTSize(int size);
+    int getFFTSize() const { return fft_analyzer.getFFTSize(); }
+
+    // Sliding analysis: a spectrum every hop samples (see FFTAnalyzer), so
+    // the display updates faster than the FFT size alone allows
+    void setHopSize(int hop);
+    int getHopSize() const { return fft_analyzer.getHopSize(); }
+    void setAnalysisWindow(FFTAnalyzer::WindowType type);
+    FFTAnalyzer::WindowType getAnalysisWindow() const { return fft_analyzer.getWindow(); }
+
+    // What fftDataReady carries, all at the same hop and window:
+    //   FFT             getFFTSize() / 2 + 1 bins (live, or from the spectrogram)
+    //   MultiResolution MultiResolutionAnalyzer::defaultLayout() merged onto
+    //                   the 8192-point grid
+    //   ConstantQ       getConstantQ().getBins() constant-Q bins
+    // The last two always run live and are set up for the file's sample rate
+    // when selected or on load.
+    enum class AnalysisMode {
+        FFT,
+        MultiResolution,
+        ConstantQ
+    };
+    void setAnalysisMode(AnalysisMode mode);
+    AnalysisMode getAnalysisMode() const { return analysis_mode.load(); }
+    const ConstantQAnalyzer& getConstantQ() const { return cq_analyzer; }
     
     // Get sample rate
-    unsigned int getSampleRate() const { return decoder.isLoaded() ? decoder.getSampleRate() : 0; }
+    unsigned int getSampleRate() const { return decoder->isLoaded() ? decoder->getSampleRate() : 0; }
     
     // Export current edited audio to a WAV file (applies current filter settings offline)
     bool exportEditedToWav(const std::string& path);
@@ -53,17 +113,32 @@ public:
     void enableHighPass(bool enabled);
     void enableBandStop(bool enabled);
     void enableBandPass(bool enabled);
+    
+    // Linear-phase FIRs or the cheaper, lower-latency biquad cascade
+    void setFilterBackend(FrequencyFilter::Backend backend,
+                          BiquadCascade::Response response = BiquadCascade::Response::Butterworth);
 
 signals:
-    // Signal emitted when new FFT data is available
+    // Signal emitted when new FFT data is available (on the GUI thread, at
+    // most once per display interval during playback)
     void fftDataReady(const std::vector<float>& magnitudes);
     
     // Signal emitted when playback finishes
     void playbackFinished();
 
+    // Signals emitted by loadFileAsync (decoded and total length in seconds)
+    void loadProgress(double decodedSeconds, double totalSeconds);
+    void loadFinished(bool success);
+
 private:
-    AudioDecoder decoder;
+    PcmCache pcm_cache; // Declared before decoders, which may still be writing to it
+    std::unique_ptr<AudioDecoder> decoder; // Never null; replaced whole on load
+    AudioDecoder::SampleStorage sample_storage;
     FFTAnalyzer fft_analyzer; // For visualization
+    MultiResolutionAnalyzer multi_analyzer; // Replace fft_analyzer in their
+    ConstantQAnalyzer cq_analyzer;          // analysis modes
+    std::atomic<AnalysisMode> analysis_mode;
+    int hop_size; // As last set; the analyzers report it clamped to their size
     FrequencyFilter frequency_filter;
     
     PaStream* stream;
@@ -71,9 +146,74 @@ private:
     bool paused;
     size_t current_position;
     
-    // Thread-safe filter parameter updates
+    // Serializes filter parameter updates (and copies of the filter) off the
+    // audio thread; the audio callback never takes it
     QMutex filter_mutex;
     
+    // Held while the analyzers are fed or reconfigured. The audio callback
+    // only ever tries it (skipping the block's analysis if it is taken), so
+    // holders off the audio thread cannot stall playback.
+    QMutex analyzer_mutex;
+    
+    // Scratch blocks for the audio callback: planar frames from readFrames
+    // (or deinterleaved from the stream), and interleaved stream frames
+    SampleBuffer render_block;
+    std::vector<float*> render_channels;
+    std::vector<float> stream_block;
+    static constexpr size_t RENDER_BLOCK_FRAMES = 4096;
+    static constexpr size_t EXPORT_DECODE_FRAMES = 1 << 18; // Per libmad priming, ~6 s at 44.1 kHz
+    static constexpr int DEFAULT_HOP_SIZE = 256; // ~6 ms at 44.1 kHz
+    static constexpr int DISPLAY_INTERVAL_MS = 16;
+    
+    // The live analyzers are fed the mono mix through this delay line,
+    // frequency_filter.getDelay() samples behind (up to
+    // DISPLAY_DELAY_FRAMES - 1), so the visuals match what is heard; the
+    // spectrogram is looked up that far back for the same reason
+    static constexpr size_t DISPLAY_DELAY_FRAMES = 1 << 15;
+    std::vector<float> display_delay;
+    size_t display_delay_pos;
+    size_t displayPosition() const;
+    
+    // Latest unfiltered spectrum of the live analyzers, for the display
+    // timer to show. The audio callback only tries live_mutex (dropping the
+    // spectrum if it is taken) and never allocates: live_spectrum is
+    // reserved for the largest spectrum any analyzer produces.
+    QMutex live_mutex;
+    std::vector<float> live_spectrum;
+    AnalysisMode live_mode;
+    bool live_fresh;
+    
+    // Background loading: the worker leaves its decoder in pending_decoder
+    // and finishLoad swaps it in on the GUI thread. Results from a load that
+    // was cancelled or superseded are recognised by their generation.
+    std::thread load_thread;
+    std::atomic<bool> load_cancel;
+    std::mutex pending_mutex;
+    std::unique_ptr<AudioDecoder> pending_decoder;
+    unsigned int load_generation;
+    bool loading;
+    
+    // Full-track spectrogram, recomputed on spectrogram_thread after each
+    // load and analysis settings change. Until finishSpectrogram publishes
+    // it (GUI thread), the audio callback feeds fft_analyzer as before.
+    std::shared_ptr<const Spectrogram> spectrogram;
+    std::atomic<bool> spectrogram_ready;
+    std::thread spectrogram_thread;
+    std::atomic<bool> spectrogram_cancel;
+    unsigned int spectrogram_generation;
+    QTimer* display_timer;
+    
+    std::unique_ptr<AudioDecoder> createDecoder();
+    void installDecoder(std::unique_ptr<AudioDecoder> fresh);
+    
+    // stopPlayback without rewinding the decoder's stream
+    void haltPlayback();
+    void finishLoad(unsigned int generation, bool ok);
+    void configureAnalyzers();
+    void startSpectrogram();
+    void cancelSpectrogram();
+    void finishSpectrogram(unsigned int generation, std::shared_ptr<const Spectrogram> result);
+    
     // PortAudio callback (static, calls instance method)
     static int audioCallback(const void* input, void* output,
                             unsigned long frameCount,
@@ -84,6 +224,18 @@ private:
     // Instance callback method
     int processAudio(const void* input, void* output, unsigned long frameCount);
     
+    // Analyze, filter and write a block of planar samples to the interleaved
+    // output buffer (the samples are filtered in place)
+    void renderSamples(float* const* samples, size_t count, float* out, unsigned int channels);
+    
+    // Feed one mono sample to the mode's analyzer; its new spectrum, or null
+    // if it has none yet
+    const std::vector<float>* analyzeSample(AnalysisMode mode, float sample);
+    
+    // Emit fftDataReady with the latest live spectrum, filtered for display,
+    // if the callback has published one since the last call
+    void showLiveSpectrum();
+    
     // Initialize PortAudio
     bool initializePortAudio();
     void cleanupPortAudio();
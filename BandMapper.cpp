@@ -0,0 +1,197 @@
+#include "BandMapper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float hzToMel(float hz) {
+    return 2595.0f * std::log10(1.0f + hz / 700.0f);
+}
+
+float melToHz(float mel) {
+    return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+} // namespace
+
+BandMapper::BandMapper()
+    : scale(Scale::Log), fft_size(0), input_bins(0), sample_rate(0) {
+}
+
+void BandMapper::clear() {
+    first_bin.clear();
+    bin_count.clear();
+    offset.clear();
+    weights.clear();
+    low_hz.clear();
+    high_hz.clear();
+    center_hz.clear();
+}
+
+bool BandMapper::configure(Scale newScale, int bands, int fftSize, unsigned int sampleRate,
+                           float minHz, float maxHz) {
+    clear();
+    scale = newScale;
+    fft_size = fftSize;
+    input_bins = fftSize / 2 + 1;
+    sample_rate = sampleRate;
+
+    float nyquist = sampleRate / 2.0f;
+    if (maxHz <= 0.0f || maxHz > nyquist) {
+        maxHz = nyquist;
+    }
+    if (fftSize < 2 || sampleRate == 0 || minHz <= 0.0f || minHz >= maxHz ||
+        (scale != Scale::ThirdOctave && bands <= 0)) {
+        input_bins = 0;
+        return false;
+    }
+
+    switch (scale) {
+    case Scale::ThirdOctave: {
+        // Centers 1000 * 2^(k/3); keep every band that overlaps the range
+        int firstK = (int)std::ceil(3.0 * std::log2(minHz / 1000.0) - 0.5);
+        int lastK = (int)std::floor(3.0 * std::log2(maxHz / 1000.0) + 0.5);
+        for (int k = firstK; k <= lastK; k++) {
+            float center = 1000.0f * std::pow(2.0f, k / 3.0f);
+            float low = std::max(minHz, center * std::pow(2.0f, -1.0f / 6.0f));
+            float high = std::min(maxHz, center * std::pow(2.0f, 1.0f / 6.0f));
+            if (high > low) {
+                addRectangularBand(low, high, center);
+            }
+        }
+        break;
+    }
+    case Scale::Mel: {
+        // bands + 2 points equally spaced in mel; band b rises from point b
+        // to a peak at b + 1 and falls to zero at b + 2
+        float melMin = hzToMel(minHz);
+        float melStep = (hzToMel(maxHz) - melMin) / (bands + 1);
+        for (int b = 0; b < bands; b++) {
+            addTriangularBand(melToHz(melMin + b * melStep),
+                              melToHz(melMin + (b + 1) * melStep),
+                              melToHz(melMin + (b + 2) * melStep));
+        }
+        break;
+    }
+    case Scale::Log: {
+        float ratio = maxHz / minHz;
+        for (int b = 0; b < bands; b++) {
+            float low = minHz * std::pow(ratio, (float)b / bands);
+            float high = minHz * std::pow(ratio, (float)(b + 1) / bands);
+            addRectangularBand(low, high, std::sqrt(low * high));
+        }
+        break;
+    }
+    }
+
+    return !first_bin.empty();
+}
+
+void BandMapper::addRectangularBand(float lowHz, float highHz, float centerHz) {
+    // Bin k covers [k - 0.5, k + 0.5) in bin units; weight each bin by how
+    // much of it lies inside the band, so bands narrower than a bin
+    // (low frequencies at small FFT sizes) still pick up the right bin
+    float binsPerHz = (float)fft_size / sample_rate;
+    float a = std::max(-0.5f, lowHz * binsPerHz);
+    float b = std::min(input_bins - 0.5f, highHz * binsPerHz);
+    int first = std::max(0, (int)std::floor(a + 0.5f));
+    int last = std::min(input_bins - 1, (int)std::ceil(b - 0.5f));
+
+    std::vector<float> bandWeights;
+    for (int k = first; k <= last; k++) {
+        bandWeights.push_back(std::max(0.0f, std::min(b, k + 0.5f) - std::max(a, k - 0.5f)));
+    }
+    addBand(first, bandWeights, lowHz, centerHz, highHz);
+}
+
+void BandMapper::addTriangularBand(float lowHz, float centerHz, float highHz) {
+    float binsPerHz = (float)fft_size / sample_rate;
+    float l = lowHz * binsPerHz;
+    float c = centerHz * binsPerHz;
+    float u = highHz * binsPerHz;
+    int first = std::max(0, (int)std::ceil(l));
+    int last = std::min(input_bins - 1, (int)std::floor(u));
+
+    std::vector<float> bandWeights;
+    for (int k = first; k <= last; k++) {
+        float w = (k <= c) ? (k - l) / (c - l) : (u - k) / (u - c);
+        bandWeights.push_back(std::max(0.0f, w));
+    }
+
+    // A triangle narrower than the bin spacing may fall between two bin
+    // centers; interpolate the spectrum at its peak instead
+    float sum = 0.0f;
+    for (float w : bandWeights) {
+        sum += w;
+    }
+    if (sum <= 0.0f) {
+        float pos = std::min(std::max(c, 0.0f), (float)(input_bins - 1));
+        first = std::min((int)pos, input_bins - 2);
+        float frac = pos - first;
+        bandWeights.assign({1.0f - frac, frac});
+    }
+
+    // Report the points where neighbouring triangles cross as the edges, so
+    // the bands tile the range
+    float melCenter = hzToMel(centerHz);
+    addBand(first, bandWeights,
+            melToHz((hzToMel(lowHz) + melCenter) / 2.0f), centerHz,
+            melToHz((melCenter + hzToMel(highHz)) / 2.0f));
+}
+
+void BandMapper::addBand(int firstBin, const std::vector<float>& bandWeights,
+                         float lowHz, float centerHz, float highHz) {
+    // Trim zero weights at either end and normalize to a weighted mean
+    size_t begin = 0;
+    size_t end = bandWeights.size();
+    while (begin < end && bandWeights[begin] <= 0.0f) {
+        begin++;
+    }
+    while (end > begin && bandWeights[end - 1] <= 0.0f) {
+        end--;
+    }
+    float sum = 0.0f;
+    for (size_t i = begin; i < end; i++) {
+        sum += bandWeights[i];
+    }
+
+    first_bin.push_back(firstBin + (int)begin);
+    offset.push_back(weights.size());
+    if (sum > 0.0f) {
+        for (size_t i = begin; i < end; i++) {
+            weights.push_back(bandWeights[i] / sum);
+        }
+        bin_count.push_back((int)(end - begin));
+    } else {
+        // Band entirely outside the spectrum; keep it so band indices stay
+        // aligned with the frequency layout, but it reads as zero
+        bin_count.push_back(0);
+    }
+
+    low_hz.push_back(lowHz);
+    center_hz.push_back(centerHz);
+    high_hz.push_back(highHz);
+}
+
+void BandMapper::apply(const float* magnitudes, float* out) const {
+    size_t bands = first_bin.size();
+    for (size_t b = 0; b < bands; b++) {
+        const float* m = magnitudes + first_bin[b];
+        const float* w = weights.data() + offset[b];
+        int count = bin_count[b];
+        float sum = 0.0f;
+        for (int i = 0; i < count; i++) {
+            sum += w[i] * m[i];
+        }
+        out[b] = sum;
+    }
+}
+
+bool BandMapper::apply(const std::vector<float>& magnitudes, std::vector<float>& out) const {
+    if (empty() || magnitudes.size() != (size_t)input_bins) {
+        return false;
+    }
+    out.resize(first_bin.size());
+    apply(magnitudes.data(), out.data());
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef BANDMAPPER_H
+#define BANDMAPPER_H
+
+#include <vector>
+#include <cstddef>
+
+// Aggregates a linear FFT spectrum into perceptual display bands. Each band
+// is a weighted mean of the contiguous run of bins it overlaps; the weights
+// are precomputed by configure() and stored sparsely (first bin, count and
+// offset into one packed weight array per band), so apply() touches only
+// the bins each band covers, in ascending order.
+class BandMapper {
+public:
+    enum class Scale {
+        ThirdOctave, // ISO 1/3-octave bands (base 2, centered on 1 kHz)
+        Mel,         // Overlapping triangular filters equally spaced in mel
+        Log          // Rectangular bands equally spaced in log frequency
+    };
+
+    static constexpr float DEFAULT_MIN_HZ = 20.0f;
+
+    BandMapper();
+
+    // Build the weights for spectra of fftSize / 2 + 1 bins at sampleRate,
+    // covering minHz..maxHz (maxHz <= 0 or above Nyquist: up to Nyquist).
+    // bands sets the count for Mel and Log; ThirdOctave has one band per
+    // standard center frequency in the range and ignores it. Returns false
+    // (leaving the mapper empty) for an invalid size, rate or range.
+    bool configure(Scale scale, int bands, int fftSize, unsigned int sampleRate,
+                   float minHz = DEFAULT_MIN_HZ, float maxHz = 0.0f);
+
+    // out[band] = sum of weight * magnitudes[bin] over the band's bins.
+    // magnitudes holds getInputBins() values, out getBands().
+    void apply(const float* magnitudes, float* out) const;
+
+    // Resizes out; does nothing to it if magnitudes has the wrong length
+    bool apply(const std::vector<float>& magnitudes, std::vector<float>& out) const;
+
+    Scale getScale() const { return scale; }
+    int getBands() const { return (int)first_bin.size(); }
+    int getInputBins() const { return input_bins; }
+    int getFFTSize() const { return fft_size; }
+    unsigned int getSampleRate() const { return sample_rate; }
+    bool empty() const { return first_bin.empty(); }
+
+    // Edges and center of a band in Hz
+    float getLowHz(int band) const { return low_hz[band]; }
+    float getHighHz(int band) const { return high_hz[band]; }
+    float getCenterHz(int band) const { return center_hz[band]; }
+
+private:
+    Scale scale;
+    int fft_size;
+    int input_bins;
+    unsigned int sample_rate;
+
+    // Sparse weights: band b covers bins first_bin[b] .. first_bin[b] +
+    // bin_count[b] - 1 with weights[offset[b] ..]
+    std::vector<int> first_bin;
+    std::vector<int> bin_count;
+    std::vector<size_t> offset;
+    std::vector<float> weights;
+
+    std::vector<float> low_hz;
+    std::vector<float> high_hz;
+    std::vector<float> center_hz;
+
+    void clear();
+    void addRectangularBand(float lowHz, float highHz, float centerHz);
+    void addTriangularBand(float lowHz, float centerHz, float highHz);
+    void addBand(int firstBin, const std::vector<float>& bandWeights,
+                 float lowHz, float centerHz, float highHz);
+};
+
+#endif // BANDMAPPER_H
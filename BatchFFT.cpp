@@ -0,0 +1,71 @@
+#include "BatchFFT.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t MAX_BATCH_FLOATS = 1 << 22; // 16 MB of input per call
+
+} // namespace
+
+BatchFFT::BatchFFT(int fftSize, int hop, FFTAnalyzer::WindowType windowType, int batchFrames)
+    : fft_size(fftSize), hop_size(hop > 0 ? hop : fftSize),
+      batch_frames(std::max(1, std::min(batchFrames, (int)(MAX_BATCH_FLOATS / fftSize)))),
+      spectrum_scale(SimdKernels::SpectrumScale::Magnitude) {
+    plan = FFTPlanCache::getBatch(fft_size, batch_frames);
+    window = fftwf_alloc_real(fft_size);
+    FFTAnalyzer::fillWindow(windowType, window, fft_size);
+    frames_in = fftwf_alloc_real((size_t)batch_frames * fft_size);
+    spectra = fftwf_alloc_complex((size_t)batch_frames * getBins());
+}
+
+BatchFFT::~BatchFFT() {
+    fftwf_free(window);
+    fftwf_free(frames_in);
+    fftwf_free(spectra);
+}
+
+size_t BatchFFT::frameCount(size_t length) const {
+    if (length < (size_t)fft_size) {
+        return 0;
+    }
+    return (length - fft_size) / hop_size + 1;
+}
+
+void BatchFFT::computeMagnitudes(const float* signal, size_t frames, float* out, size_t outStride) {
+    if (outStride == 0) {
+        outStride = getBins();
+    }
+    for (size_t done = 0; done < frames; done += batch_frames) {
+        int count = (int)std::min<size_t>(batch_frames, frames - done);
+        transformBatch(signal + done * hop_size, count, out + done * outStride, outStride);
+    }
+}
+
+void BatchFFT::transformBatch(const float* signal, int count, float* out, size_t outStride) {
+    // Window each frame into its row; a short final batch is zero-filled so
+    // the one plan (made for batch_frames rows) still applies
+    for (int f = 0; f < count; f++) {
+        const float* __restrict frame = signal + (size_t)f * hop_size;
+        float* __restrict row = frames_in + (size_t)f * fft_size;
+        for (int i = 0; i < fft_size; i++) {
+            row[i] = frame[i] * window[i];
+        }
+    }
+    if (count < batch_frames) {
+        memset(frames_in + (size_t)count * fft_size, 0,
+               sizeof(float) * (size_t)(batch_frames - count) * fft_size);
+    }
+
+    fftwf_execute_dft_r2c(plan, frames_in, spectra);
+
+    const int bins = getBins();
+    if (outStride == (size_t)bins) {
+        SimdKernels::complexToSpectrum(&spectra[0][0], out, (size_t)count * bins, spectrum_scale);
+        return;
+    }
+    for (int f = 0; f < count; f++) {
+        SimdKernels::complexToSpectrum(&spectra[(size_t)f * bins][0], out + (size_t)f * outStride,
+                                       bins, spectrum_scale);
+    }
+}
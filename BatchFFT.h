@@ -0,0 +1,56 @@
+#ifndef BATCHFFT_H
+#define BATCHFFT_H
+
+#include <fftw3.h>
+#include <cstddef>
+#include "FFTAnalyzer.h"
+
+// Offline STFT engine: windows a batch of hop-spaced frames of a signal into
+// one matrix and transforms them all with a single fftwf_plan_many_dft_r2c
+// call, producing a frames x bins magnitude matrix. Whole-track spectrograms
+// go through this instead of one FFTAnalyzer call per frame.
+class BatchFFT {
+public:
+    // Frames per FFTW call; capped so the input matrix stays around 16 MB
+    static constexpr int DEFAULT_BATCH_FRAMES = 256;
+
+    BatchFFT(int fftSize, int hop,
+             FFTAnalyzer::WindowType windowType = FFTAnalyzer::WindowType::Rectangular,
+             int batchFrames = DEFAULT_BATCH_FRAMES);
+    ~BatchFFT();
+
+    BatchFFT(const BatchFFT&) = delete;
+    BatchFFT& operator=(const BatchFFT&) = delete;
+
+    int getFFTSize() const { return fft_size; }
+    int getHopSize() const { return hop_size; }
+    int getBins() const { return fft_size / 2 + 1; }
+    int getBatchFrames() const { return batch_frames; }
+
+    // Scale of the output rows (default Magnitude)
+    void setSpectrumScale(SimdKernels::SpectrumScale scale) { spectrum_scale = scale; }
+    SimdKernels::SpectrumScale getSpectrumScale() const { return spectrum_scale; }
+
+    // Frames that fit completely in length samples
+    size_t frameCount(size_t length) const;
+
+    // Spectra of frames frames of signal, frame f starting at sample
+    // f * getHopSize(), written row by row to out, rows outStride floats
+    // apart (0: getBins(), i.e. a dense frames x bins matrix). signal must
+    // hold at least (frames - 1) * hop + fftSize samples.
+    void computeMagnitudes(const float* signal, size_t frames, float* out, size_t outStride = 0);
+
+private:
+    int fft_size;
+    int hop_size;
+    int batch_frames;
+    SimdKernels::SpectrumScale spectrum_scale;
+    fftwf_plan plan;      // Shared, owned by FFTPlanCache
+    float* window;
+    float* frames_in;     // batch_frames x fft_size
+    fftwf_complex* spectra; // batch_frames x bins
+
+    void transformBatch(const float* signal, int count, float* out, size_t outStride);
+};
+
+#endif // BATCHFFT_H
@@ -0,0 +1,234 @@
+#include "BiquadCascade.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+
+namespace {
+
+using Complex = std::complex<double>;
+
+enum class Kind { LowPass, HighPass, BandPass, BandStop };
+
+constexpr unsigned int LANES = SimdKernels::BIQUAD_LANES;
+constexpr size_t COEFFS_PER_SECTION = 5 * LANES;
+constexpr size_t STATE_PER_SECTION = 2 * LANES;
+
+// State this small is far below audibility (-400 dB). Zeroing it once per
+// block keeps a recursion decaying through silence out of the subnormal
+// range, where x86 float arithmetic is many times slower.
+constexpr float DENORMAL_THRESHOLD = 1e-20f;
+
+void flushDenormals(float* state, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (std::fabs(state[i]) < DENORMAL_THRESHOLD) {
+            state[i] = 0.0f;
+        }
+    }
+}
+
+// One section from an analog pole (its conjugate is implied), with the
+// section's zeros given as a numerator, scaled to unit gain at refZ
+BiquadCascade::Section makeSection(Complex pole, double fs2, double b0, double b1, double b2,
+                                   Complex refZ) {
+    Complex z = (fs2 + pole) / (fs2 - pole);
+    double a1 = -2.0 * z.real();
+    double a2 = std::norm(z);
+    Complex w = 1.0 / refZ;
+    double gain = std::abs((b0 + b1 * w + b2 * w * w) / (1.0 + a1 * w + a2 * w * w));
+    double scale = (gain > 0.0) ? 1.0 / gain : 1.0;
+    return {(float)(b0 * scale), (float)(b1 * scale), (float)(b2 * scale), (float)a1, (float)a2};
+}
+
+// Butterworth of the given (even) prototype order
+std::vector<BiquadCascade::Section> butterworth(Kind kind, double lowHz, double highHz,
+                                                double sampleRate, int order) {
+    std::vector<BiquadCascade::Section> sections;
+    const double fs2 = 2.0 * sampleRate;
+    auto warp = [&](double hz) { return fs2 * std::tan(M_PI * hz / sampleRate); };
+    const double wl = warp(lowHz);
+    const double wh = warp(highHz);
+    const double w0 = std::sqrt(wl * wh);
+    const double bw = wh - wl;
+    const double center = 2.0 * std::atan(w0 / fs2); // Digital band center, rad/sample
+    const Complex dc(1.0, 0.0);
+    const Complex nyquist(-1.0, 0.0);
+    const Complex atCenter = std::polar(1.0, center);
+
+    // Prototype poles (cutoff 1 rad/s) in the upper half-plane; each one
+    // with its conjugate makes a section (two for the band transforms)
+    for (int k = 0; k < order / 2; k++) {
+        Complex p = std::polar(1.0, M_PI * (2 * k + 1 + order) / (2.0 * order));
+        switch (kind) {
+        case Kind::LowPass:
+            sections.push_back(makeSection(wl * p, fs2, 1.0, 2.0, 1.0, dc));
+            break;
+        case Kind::HighPass:
+            sections.push_back(makeSection(wl / p, fs2, 1.0, -2.0, 1.0, nyquist));
+            break;
+        case Kind::BandPass:
+        case Kind::BandStop: {
+            // s -> (s^2 + w0^2) / (s bw) resp. s bw / (s^2 + w0^2): each
+            // prototype pole becomes the two roots of s^2 - c s + w0^2
+            Complex c = (kind == Kind::BandPass) ? p * bw : bw / p;
+            Complex root = std::sqrt(c * c - 4.0 * w0 * w0);
+            for (Complex pole : {(c + root) / 2.0, (c - root) / 2.0}) {
+                if (kind == Kind::BandPass) {
+                    sections.push_back(makeSection(pole, fs2, 1.0, 0.0, -1.0, atCenter));
+                } else {
+                    sections.push_back(makeSection(pole, fs2, 1.0, -2.0 * std::cos(center), 1.0, dc));
+                }
+            }
+            break;
+        }
+        }
+    }
+    return sections;
+}
+
+std::vector<BiquadCascade::Section> design(Kind kind, double lowHz, double highHz, double sampleRate,
+                                           int order, BiquadCascade::Response response) {
+    double nyquist = sampleRate / 2.0;
+    if (lowHz <= 0.0 || highHz >= nyquist || highHz < lowHz || order <= 0) {
+        return std::vector<BiquadCascade::Section>();
+    }
+    if (response == BiquadCascade::Response::Butterworth) {
+        return butterworth(kind, lowHz, highHz, sampleRate, order + (order & 1));
+    }
+    int half = std::max(2, (order + 3) / 4 * 2);
+    std::vector<BiquadCascade::Section> sections = butterworth(kind, lowHz, highHz, sampleRate, half);
+    std::vector<BiquadCascade::Section> squared = sections;
+    squared.insert(squared.end(), sections.begin(), sections.end());
+    return squared;
+}
+
+} // namespace
+
+std::vector<BiquadCascade::Section> BiquadCascade::lowPass(float cutoffHz, float sampleRate, int order,
+                                                           Response response) {
+    return design(Kind::LowPass, cutoffHz, cutoffHz, sampleRate, order, response);
+}
+
+std::vector<BiquadCascade::Section> BiquadCascade::highPass(float cutoffHz, float sampleRate, int order,
+                                                            Response response) {
+    return design(Kind::HighPass, cutoffHz, cutoffHz, sampleRate, order, response);
+}
+
+std::vector<BiquadCascade::Section> BiquadCascade::bandPass(float lowHz, float highHz, float sampleRate,
+                                                            int order, Response response) {
+    return design(Kind::BandPass, lowHz, highHz, sampleRate, order, response);
+}
+
+std::vector<BiquadCascade::Section> BiquadCascade::bandStop(float lowHz, float highHz, float sampleRate,
+                                                            int order, Response response) {
+    return design(Kind::BandStop, lowHz, highHz, sampleRate, order, response);
+}
+
+BiquadCascade::BiquadCascade()
+    : section_count(0), channel_count(0) {
+}
+
+void BiquadCascade::setSections(const std::vector<Section>& sections) {
+    bool resize = sections.size() != section_count;
+    section_count = sections.size();
+    coeffs.resize(section_count * COEFFS_PER_SECTION);
+    for (size_t s = 0; s < section_count; s++) {
+        const float values[5] = {sections[s].b0, sections[s].b1, sections[s].b2,
+                                 sections[s].a1, sections[s].a2};
+        float* c = coeffs.data() + s * COEFFS_PER_SECTION;
+        for (int v = 0; v < 5; v++) {
+            std::fill(c + v * LANES, c + (v + 1) * LANES, values[v]);
+        }
+    }
+    if (resize) {
+        resizeState();
+    }
+}
+
+void BiquadCascade::setChannelCount(unsigned int channels) {
+    if (channels == channel_count) {
+        return;
+    }
+    channel_count = channels;
+    resizeState();
+}
+
+void BiquadCascade::resizeState() {
+    size_t groups = (channel_count + LANES - 1) / LANES;
+    state.assign(groups * section_count * STATE_PER_SECTION, 0.0f);
+}
+
+void BiquadCascade::reset() {
+    std::fill(state.begin(), state.end(), 0.0f);
+}
+
+bool BiquadCascade::copyStateFrom(const BiquadCascade& other) {
+    if (other.section_count != section_count || other.channel_count != channel_count) {
+        return false;
+    }
+    std::copy(other.state.begin(), other.state.end(), state.begin());
+    return true;
+}
+
+void BiquadCascade::process(const float* in, float* out, size_t count, unsigned int channel) {
+    if (section_count == 0 || channel >= channel_count) {
+        if (out != in) {
+            std::memmove(out, in, count * sizeof(float));
+        }
+        return;
+    }
+
+    // The channel's lane of its group, stepped one sample at a time
+    const unsigned int lane = channel % LANES;
+    float* z = state.data() + (channel / LANES) * section_count * STATE_PER_SECTION;
+    for (size_t i = 0; i < count; i++) {
+        float x = in[i];
+        for (size_t s = 0; s < section_count; s++) {
+            const float* c = coeffs.data() + s * COEFFS_PER_SECTION;
+            float* zs = z + s * STATE_PER_SECTION;
+            float y = c[0] * x + zs[lane];
+            zs[lane] = c[LANES] * x + zs[LANES + lane] - c[3 * LANES] * y;
+            zs[LANES + lane] = c[2 * LANES] * x - c[4 * LANES] * y;
+            x = y;
+        }
+        // Safety check: prevent NaN/Inf, which would otherwise stay in the
+        // recursion for good
+        if (!std::isfinite(x)) {
+            clearChannel(channel);
+            x = 0.0f;
+        }
+        out[i] = x;
+    }
+    flushDenormals(z, section_count * STATE_PER_SECTION);
+}
+
+void BiquadCascade::processChannels(float* const* channels, unsigned int channelCount, size_t count) {
+    if (section_count == 0) {
+        return;
+    }
+    channelCount = std::min(channelCount, channel_count);
+    for (unsigned int first = 0; first < channelCount; first += LANES) {
+        float* z = state.data() + (first / LANES) * section_count * STATE_PER_SECTION;
+        SimdKernels::biquadCascade(coeffs.data(), z, section_count, channels + first,
+                                   std::min(LANES, channelCount - first), count);
+        flushDenormals(z, section_count * STATE_PER_SECTION);
+    }
+    for (unsigned int ch = 0; ch < channelCount; ch++) {
+        for (size_t i = 0; i < count; i++) {
+            if (!std::isfinite(channels[ch][i])) {
+                channels[ch][i] = 0.0f;
+                clearChannel(ch);
+            }
+        }
+    }
+}
+
+void BiquadCascade::clearChannel(unsigned int channel) {
+    const unsigned int lane = channel % LANES;
+    float* z = state.data() + (channel / LANES) * section_count * STATE_PER_SECTION;
+    for (size_t s = 0; s < section_count; s++) {
+        z[s * STATE_PER_SECTION + lane] = 0.0f;
+        z[s * STATE_PER_SECTION + LANES + lane] = 0.0f;
+    }
+}
@@ -0,0 +1,76 @@
+#include "CompactSampleBuffer.h"
+#include <cstdlib>
+#include <algorithm>
+#include "SimdKernels.h"
+
+namespace {
+
+// Int16 uses the same scale as 16-bit WAV, so those samples round-trip exactly
+constexpr float INT16_SCALE = 32768.0f;
+
+} // namespace
+
+CompactSampleBuffer::CompactSampleBuffer()
+    : data(nullptr), stride(0), frames(0), channels(0), format(Format::Int16) {
+}
+
+CompactSampleBuffer::~CompactSampleBuffer() {
+    clear();
+}
+
+bool CompactSampleBuffer::allocate(Format sampleFormat, unsigned int channelCount, size_t frameCount) {
+    clear();
+    format = sampleFormat;
+    if (channelCount == 0 || frameCount == 0) {
+        return true;
+    }
+
+    const size_t samplesPerLine = ALIGNMENT / sizeof(uint16_t);
+    size_t paddedStride = (frameCount + samplesPerLine - 1) / samplesPerLine * samplesPerLine;
+
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, ALIGNMENT, paddedStride * channelCount * sizeof(uint16_t)) != 0) {
+        return false;
+    }
+
+    data = static_cast<uint16_t*>(ptr);
+    stride = paddedStride;
+    frames = frameCount;
+    channels = channelCount;
+    return true;
+}
+
+void CompactSampleBuffer::clear() {
+    free(data);
+    data = nullptr;
+    stride = 0;
+    frames = 0;
+    channels = 0;
+}
+
+void CompactSampleBuffer::write(unsigned int ch, size_t start, const float* in, size_t count) {
+    if (ch >= channels || start >= frames) {
+        return;
+    }
+    count = std::min(count, frames - start);
+    uint16_t* dst = data + ch * stride + start;
+    if (format == Format::Int16) {
+        SimdKernels::floatToInt16(in, reinterpret_cast<int16_t*>(dst), count, INT16_SCALE);
+    } else {
+        SimdKernels::floatToHalf(in, dst, count);
+    }
+}
+
+size_t CompactSampleBuffer::read(unsigned int ch, size_t start, size_t count, float* out) const {
+    if (ch >= channels || start >= frames) {
+        return 0;
+    }
+    count = std::min(count, frames - start);
+    const uint16_t* src = data + ch * stride + start;
+    if (format == Format::Int16) {
+        SimdKernels::int16ToFloat(reinterpret_cast<const int16_t*>(src), out, count, 1.0f / INT16_SCALE);
+    } else {
+        SimdKernels::halfToFloat(src, out, count);
+    }
+    return count;
+}
@@ -0,0 +1,53 @@
+#ifndef COMPACTSAMPLEBUFFER_H
+#define COMPACTSAMPLEBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Planar store at 16 bits per sample, half the size of SampleBuffer, for
+// very long recordings. Int16 is lossless for 16-bit sources; Float16 keeps
+// ~11 bits of precision at any level. Samples go in and out as float in
+// blocks, converted with SIMD kernels, so readers only ever expand the block
+// they are about to process.
+class CompactSampleBuffer {
+public:
+    enum class Format {
+        Int16,
+        Float16
+    };
+
+    static constexpr size_t ALIGNMENT = 64;
+
+    CompactSampleBuffer();
+    ~CompactSampleBuffer();
+
+    CompactSampleBuffer(const CompactSampleBuffer&) = delete;
+    CompactSampleBuffer& operator=(const CompactSampleBuffer&) = delete;
+
+    // Allocate uninitialized storage (drops any previous contents)
+    bool allocate(Format format, unsigned int channels, size_t frames);
+
+    // Release storage
+    void clear();
+
+    // Compress count float samples of one channel, starting at frame start.
+    // Disjoint ranges may be written from different threads.
+    void write(unsigned int ch, size_t start, const float* in, size_t count);
+
+    // Expand up to count samples of one channel into out; returns how many
+    size_t read(unsigned int ch, size_t start, size_t count, float* out) const;
+
+    Format getFormat() const { return format; }
+    unsigned int getChannels() const { return channels; }
+    size_t getFrames() const { return frames; }
+    bool empty() const { return frames == 0; }
+
+private:
+    uint16_t* data; // Int16 values or half-precision bits
+    size_t stride;  // Samples between channel starts (frames rounded up to ALIGNMENT)
+    size_t frames;
+    unsigned int channels;
+    Format format;
+};
+
+#endif // COMPACTSAMPLEBUFFER_H
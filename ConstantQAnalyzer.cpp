@@ -0,0 +1,260 @@
+#include "ConstantQAnalyzer.h"
+#include "FFTPlanCache.h"
+#include <fftw3.h>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <iostream>
+
+// Sparse spectral kernel: bin k is the dot product of FFT bins first_bin[k]
+// .. first_bin[k] + bin_count[k] - 1 with the complex weights at
+// weights[2 * offset[k] ..] (interleaved re, im)
+struct ConstantQAnalyzer::Kernel {
+    unsigned int sample_rate;
+    int fft_size;
+    int bins_per_octave;
+    std::vector<float> frequencies;
+    std::vector<int> first_bin;
+    std::vector<int> bin_count;
+    std::vector<size_t> offset;
+    std::vector<float> weights;
+};
+
+namespace {
+
+struct KernelKey {
+    unsigned int sample_rate;
+    float min_hz;
+    int bins_per_octave;
+    int bins;
+
+    bool operator<(const KernelKey& other) const {
+        return std::tie(sample_rate, min_hz, bins_per_octave, bins) <
+               std::tie(other.sample_rate, other.min_hz, other.bins_per_octave, other.bins);
+    }
+};
+
+} // namespace
+
+ConstantQAnalyzer::ConstantQAnalyzer()
+    : analyzer(FFTAnalyzer::MIN_FFT_SIZE), spectrum_scale(SimdKernels::SpectrumScale::Magnitude) {
+}
+
+bool ConstantQAnalyzer::configure(unsigned int sampleRate, float minHz, int binsPerOctave, int octaves) {
+    std::shared_ptr<const Kernel> fresh = getKernel(sampleRate, minHz, binsPerOctave, octaves);
+    if (!fresh || !analyzer.setFFTSize(fresh->fft_size)) {
+        return false;
+    }
+    kernel = fresh;
+    spectrum.assign(2 * fresh->frequencies.size(), 0.0f);
+    magnitudes.assign(fresh->frequencies.size(), 0.0f);
+    return true;
+}
+
+void ConstantQAnalyzer::swap(ConstantQAnalyzer& other) {
+    kernel.swap(other.kernel);
+    analyzer.swap(other.analyzer);
+    std::swap(spectrum_scale, other.spectrum_scale);
+    spectrum.swap(other.spectrum);
+    magnitudes.swap(other.magnitudes);
+}
+
+std::shared_ptr<const ConstantQAnalyzer::Kernel> ConstantQAnalyzer::getKernel(
+        unsigned int sampleRate, float minHz, int binsPerOctave, int octaves) {
+    if (sampleRate == 0 || minHz <= 0.0f || binsPerOctave <= 0 || octaves <= 0 ||
+        minHz >= sampleRate / 2.0f) {
+        return nullptr;
+    }
+
+    // Keep every bin whose upper edge is below Nyquist
+    int bins = binsPerOctave * octaves;
+    float nyquist = sampleRate / 2.0f;
+    while (bins > 1 && minHz * std::pow(2.0f, (bins - 0.5f) / binsPerOctave) > nyquist) {
+        bins--;
+    }
+
+    static std::mutex mutex;
+    static std::map<KernelKey, std::shared_ptr<const Kernel>> kernels;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    KernelKey key = {sampleRate, minHz, binsPerOctave, bins};
+    auto it = kernels.find(key);
+    if (it != kernels.end()) {
+        return it->second;
+    }
+    std::shared_ptr<const Kernel> fresh = buildKernel(sampleRate, minHz, binsPerOctave, bins);
+    if (fresh) {
+        kernels[key] = fresh;
+    }
+    return fresh;
+}
+
+std::shared_ptr<const ConstantQAnalyzer::Kernel> ConstantQAnalyzer::buildKernel(
+        unsigned int sampleRate, float minHz, int binsPerOctave, int bins) {
+    // Q: center frequency over bandwidth, for bins a semitone (or whatever
+    // 1/binsPerOctave octave is) apart
+    double q = 1.0 / (std::pow(2.0, 1.0 / binsPerOctave) - 1.0);
+    int longest = (int)std::ceil(q * sampleRate / minHz);
+    int fftSize = FFTAnalyzer::MIN_FFT_SIZE;
+    while (fftSize < longest) {
+        fftSize *= 2;
+    }
+    if (fftSize > FFTAnalyzer::MAX_FFT_SIZE) {
+        std::cerr << "Constant-Q window of " << longest << " samples exceeds the maximum FFT size"
+                  << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<Kernel> result = std::make_shared<Kernel>();
+    result->sample_rate = sampleRate;
+    result->fft_size = fftSize;
+    result->bins_per_octave = binsPerOctave;
+
+    // The temporal kernel is complex; its transform is the sum of the r2c
+    // transforms of the real and imaginary parts, which covers every bin a
+    // real input's spectrum needs
+    const int spectrumBins = fftSize / 2 + 1;
+    float* real = fftwf_alloc_real(fftSize);
+    float* imag = fftwf_alloc_real(fftSize);
+    fftwf_complex* realSpectrum = fftwf_alloc_complex(spectrumBins);
+    fftwf_complex* imagSpectrum = fftwf_alloc_complex(spectrumBins);
+    std::vector<float> window(fftSize);
+    std::vector<float> row(2 * spectrumBins);
+    fftwf_plan plan = FFTPlanCache::get(fftSize).forward.load(std::memory_order_acquire);
+
+    for (int k = 0; k < bins; k++) {
+        double frequency = minHz * std::pow(2.0, (double)k / binsPerOctave);
+        int length = std::min(fftSize, (int)std::ceil(q * sampleRate / frequency));
+
+        // Hann window of Q periods, aligned to the end of the frame so every
+        // bin tracks the newest samples. The window has unit mean; the 2 /
+        // length scale makes a sine of amplitude A read A (its negative
+        // frequency half is not in the kernel).
+        FFTAnalyzer::fillWindow(FFTAnalyzer::WindowType::Hann, window.data(), length);
+        int start = fftSize - length;
+        std::fill(real, real + start, 0.0f);
+        std::fill(imag, imag + start, 0.0f);
+        for (int n = 0; n < length; n++) {
+            double phase = 2.0 * M_PI * frequency * n / sampleRate;
+            double amplitude = 2.0 * window[n] / length;
+            real[start + n] = (float)(amplitude * std::cos(phase));
+            imag[start + n] = (float)(amplitude * std::sin(phase));
+        }
+        fftwf_execute_dft_r2c(plan, real, realSpectrum);
+        fftwf_execute_dft_r2c(plan, imag, imagSpectrum);
+
+        // Spectral kernel conj(T) / N, so that by Parseval the product with
+        // the input's spectrum equals the time-domain correlation
+        float peak = 0.0f;
+        for (int j = 0; j < spectrumBins; j++) {
+            float re = (realSpectrum[j][0] - imagSpectrum[j][1]) / fftSize;
+            float im = (realSpectrum[j][1] + imagSpectrum[j][0]) / fftSize;
+            row[2 * j] = re;
+            row[2 * j + 1] = -im;
+            peak = std::max(peak, re * re + im * im);
+        }
+
+        // One contiguous run per bin, from the first to the last entry above
+        // the threshold
+        float threshold = SPARSITY_THRESHOLD * SPARSITY_THRESHOLD * peak;
+        int first = 0;
+        int last = spectrumBins - 1;
+        auto power = [&row](int j) { return row[2 * j] * row[2 * j] + row[2 * j + 1] * row[2 * j + 1]; };
+        while (first < last && power(first) < threshold) {
+            first++;
+        }
+        while (last > first && power(last) < threshold) {
+            last--;
+        }
+        result->frequencies.push_back((float)frequency);
+        result->first_bin.push_back(first);
+        result->bin_count.push_back(last - first + 1);
+        result->offset.push_back(result->weights.size() / 2);
+        result->weights.insert(result->weights.end(), row.begin() + 2 * first, row.begin() + 2 * (last + 1));
+    }
+
+    fftwf_free(real);
+    fftwf_free(imag);
+    fftwf_free(realSpectrum);
+    fftwf_free(imagSpectrum);
+    return result;
+}
+
+bool ConstantQAnalyzer::addSample(float sample) {
+    if (!kernel || !analyzer.addSample(sample)) {
+        return false;
+    }
+    applyKernel();
+    return true;
+}
+
+void ConstantQAnalyzer::computeFromBuffer(const float* buffer) {
+    if (!kernel) {
+        return;
+    }
+    analyzer.computeFFTFromBuffer(buffer, kernel->fft_size);
+    applyKernel();
+}
+
+void ConstantQAnalyzer::applyKernel() {
+    const fftwf_complex* input = analyzer.getFFTOutput();
+    const int bins = (int)kernel->first_bin.size();
+    for (int k = 0; k < bins; k++) {
+        const fftwf_complex* x = input + kernel->first_bin[k];
+        const float* w = kernel->weights.data() + 2 * kernel->offset[k];
+        int count = kernel->bin_count[k];
+        float re = 0.0f;
+        float im = 0.0f;
+        for (int j = 0; j < count; j++) {
+            re += x[j][0] * w[2 * j] - x[j][1] * w[2 * j + 1];
+            im += x[j][0] * w[2 * j + 1] + x[j][1] * w[2 * j];
+        }
+        spectrum[2 * k] = re;
+        spectrum[2 * k + 1] = im;
+    }
+    SimdKernels::complexToSpectrum(spectrum.data(), magnitudes.data(), bins, spectrum_scale);
+}
+
+void ConstantQAnalyzer::reset() {
+    analyzer.reset();
+    std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
+}
+
+int ConstantQAnalyzer::getBins() const {
+    return kernel ? (int)kernel->frequencies.size() : 0;
+}
+
+int ConstantQAnalyzer::getBinsPerOctave() const {
+    return kernel ? kernel->bins_per_octave : 0;
+}
+
+int ConstantQAnalyzer::getFFTSize() const {
+    return kernel ? kernel->fft_size : 0;
+}
+
+unsigned int ConstantQAnalyzer::getSampleRate() const {
+    return kernel ? kernel->sample_rate : 0;
+}
+
+const std::vector<float>& ConstantQAnalyzer::getFrequencies() const {
+    static const std::vector<float> none;
+    return kernel ? kernel->frequencies : none;
+}
+
+float ConstantQAnalyzer::getFrequency(int bin) const {
+    return kernel->frequencies[bin];
+}
+
+float ConstantQAnalyzer::getLowHz(int bin) const {
+    return kernel->frequencies[bin] * std::pow(2.0f, -0.5f / kernel->bins_per_octave);
+}
+
+float ConstantQAnalyzer::getHighHz(int bin) const {
+    return kernel->frequencies[bin] * std::pow(2.0f, 0.5f / kernel->bins_per_octave);
+}
+
+size_t ConstantQAnalyzer::getKernelEntries() const {
+    return kernel ? kernel->weights.size() / 2 : 0;
+}
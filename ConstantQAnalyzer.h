@@ -0,0 +1,99 @@
+#ifndef CONSTANTQANALYZER_H
+#define CONSTANTQANALYZER_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include "FFTAnalyzer.h"
+#include "SimdKernels.h"
+
+// Constant-Q transform: geometrically spaced bins, a fixed number per
+// octave, each analyzed over a window of Q periods of its own frequency
+// (long for the bass, short for the treble).
+//
+// Uses the spectral kernel method (Brown & Puckette): every bin's windowed
+// complex exponential is transformed once, at configure time, and the
+// result thresholded to the handful of FFT bins around its frequency. A CQ
+// frame is then one FFT of the longest window (via FFTAnalyzer, which also
+// provides the sliding input) followed by a sparse product with the kernel.
+// Kernels are cached process-wide, so reconfiguring or creating several
+// analyzers with the same settings does not rebuild them.
+class ConstantQAnalyzer {
+public:
+    static constexpr float DEFAULT_MIN_HZ = 32.703f; // C1
+    static constexpr int DEFAULT_BINS_PER_OCTAVE = 12;
+    static constexpr int DEFAULT_OCTAVES = 9;
+
+    // Kernel entries below this fraction of their bin's peak are dropped
+    static constexpr float SPARSITY_THRESHOLD = 0.005f;
+
+    ConstantQAnalyzer();
+
+    ConstantQAnalyzer(const ConstantQAnalyzer&) = delete;
+    ConstantQAnalyzer& operator=(const ConstantQAnalyzer&) = delete;
+
+    // Bins from minHz up binsPerOctave per octave for octaves octaves,
+    // stopping below Nyquist. The FFT size is the power of two holding the
+    // lowest bin's window; fails if that exceeds FFTAnalyzer::MAX_FFT_SIZE.
+    // Clears the input.
+    bool configure(unsigned int sampleRate, float minHz = DEFAULT_MIN_HZ,
+                   int binsPerOctave = DEFAULT_BINS_PER_OCTAVE, int octaves = DEFAULT_OCTAVES);
+    bool isConfigured() const { return kernel != nullptr; }
+
+    // Exchange everything with other without allocating, so an analyzer
+    // configured elsewhere can be swapped in under a lock
+    void swap(ConstantQAnalyzer& other);
+
+    // Samples between frames in addSample (see FFTAnalyzer::setHopSize)
+    void setHopSize(int hop) { analyzer.setHopSize(hop); }
+    int getHopSize() const { return analyzer.getHopSize(); }
+
+    // Scale of getMagnitudes() (default Magnitude: a sine at a bin's center
+    // frequency reads its amplitude)
+    void setSpectrumScale(SimdKernels::SpectrumScale scale) { spectrum_scale = scale; }
+    SimdKernels::SpectrumScale getSpectrumScale() const { return spectrum_scale; }
+
+    // Process a single sample; returns true when a new frame is ready
+    bool addSample(float sample);
+
+    // Compute a frame from getFFTSize() samples, newest last
+    void computeFromBuffer(const float* buffer);
+
+    // Latest frame (size: getBins())
+    const std::vector<float>& getMagnitudes() const { return magnitudes; }
+
+    void reset();
+
+    int getBins() const;
+    int getBinsPerOctave() const;
+    int getFFTSize() const;
+    unsigned int getSampleRate() const;
+
+    // Center frequencies of all bins, and band edges (half a bin either
+    // side) in Hz
+    const std::vector<float>& getFrequencies() const;
+    float getFrequency(int bin) const;
+    float getLowHz(int bin) const;
+    float getHighHz(int bin) const;
+
+    // Complex multiply-adds per frame, on top of the FFT
+    size_t getKernelEntries() const;
+
+private:
+    struct Kernel;
+
+    static std::shared_ptr<const Kernel> getKernel(unsigned int sampleRate, float minHz,
+                                                   int binsPerOctave, int octaves);
+    static std::shared_ptr<const Kernel> buildKernel(unsigned int sampleRate, float minHz,
+                                                     int binsPerOctave, int bins);
+
+    std::shared_ptr<const Kernel> kernel;
+    FFTAnalyzer analyzer; // Rectangular: the windows are part of the kernel
+    SimdKernels::SpectrumScale spectrum_scale;
+    std::vector<float> spectrum; // getBins() interleaved complex values
+    std::vector<float> magnitudes;
+
+    void applyKernel();
+};
+
+#endif // CONSTANTQANALYZER_H
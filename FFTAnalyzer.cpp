@@ -1,46 +1,159 @@
 #include "FFTAnalyzer.h"
+#include "SimdKernels.h"
 #include <cstring>
+#include <iostream>
+#include <algorithm>
 
-FFTAnalyzer::FFTAnalyzer() 
-    : sample_count(0), ready(false) {
-    // Allocate FFTW arrays
-    fftw_in = (double*) fftw_malloc(sizeof(double) * FFT_SIZE);
-    fftw_out = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (FFT_SIZE / 2 + 1));
-    ifftw_out = (double*) fftw_malloc(sizeof(double) * FFT_SIZE);
-    
-    // Create FFT plan (real to complex)
-    fftw_plan = fftw_plan_dft_r2c_1d(FFT_SIZE, fftw_in, fftw_out, FFTW_ESTIMATE);
-    
-    // Create IFFT plan (complex to real)
-    ifftw_plan_var = fftw_plan_dft_c2r_1d(FFT_SIZE, fftw_out, ifftw_out, FFTW_ESTIMATE);
+namespace {
+
+// out = in * window, the only per-hop pass over the frame
+void applyWindow(const float* __restrict in, const float* __restrict window,
+                 float* __restrict out, int n) {
+    for (int i = 0; i < n; i++) {
+        out[i] = in[i] * window[i];
+    }
+}
+
+} // namespace
+
+FFTAnalyzer::FFTAnalyzer(int fftSize)
+    : fft_size(0), plans(nullptr), spectrum_scale(SimdKernels::SpectrumScale::Magnitude),
+      fftw_in(nullptr), fftw_out(nullptr), ifftw_out(nullptr),
+      ring(nullptr), write_pos(0), filled(0), since_fft(0), hop_size(0),
+      window_type(WindowType::Rectangular), window(nullptr), ready(false) {
+    if (!setFFTSize(fftSize)) {
+        setFFTSize(DEFAULT_FFT_SIZE);
+    }
+}
+
+FFTAnalyzer::~FFTAnalyzer() {
+    freeBuffers();
+}
+
+bool FFTAnalyzer::setFFTSize(int size) {
+    if (size < MIN_FFT_SIZE || size > MAX_FFT_SIZE) {
+        std::cerr << "Unsupported FFT size " << size << " (expected "
+                  << MIN_FFT_SIZE << ".." << MAX_FFT_SIZE << ")" << std::endl;
+        return false;
+    }
+    if (size == fft_size) {
+        reset();
+        return true;
+    }
     
-    // Initialize magnitudes vector
-    magnitudes.resize(FFT_SIZE / 2 + 1, 0.0f);
+    // Allocate FFTW arrays (fftwf_malloc matches the plans' alignment)
+    freeBuffers();
+    fft_size = size;
+    fftw_in = fftwf_alloc_real(fft_size);
+    fftw_out = fftwf_alloc_complex(fft_size / 2 + 1);
+    ifftw_out = fftwf_alloc_real(fft_size);
+    ring = fftwf_alloc_real(2 * fft_size);
+    window = fftwf_alloc_real(fft_size);
+    plans = &FFTPlanCache::get(fft_size);
+    fillWindow(window_type, window, fft_size);
     
-    // Initialize input buffer
-    memset(fftw_in, 0, sizeof(double) * FFT_SIZE);
-    memset(ifftw_out, 0, sizeof(double) * FFT_SIZE);
+    magnitudes.assign(fft_size / 2 + 1, 0.0f);
+    memset(fftw_out, 0, sizeof(fftwf_complex) * (fft_size / 2 + 1));
+    reset();
+    return true;
 }
 
-FFTAnalyzer::~FFTAnalyzer() {
-    fftw_destroy_plan(fftw_plan);
-    fftw_destroy_plan(ifftw_plan_var);
-    fftw_free(fftw_in);
-    fftw_free(fftw_out);
-    fftw_free(ifftw_out);
+void FFTAnalyzer::swap(FFTAnalyzer& other) {
+    std::swap(fft_size, other.fft_size);
+    std::swap(plans, other.plans);
+    std::swap(spectrum_scale, other.spectrum_scale);
+    std::swap(fftw_in, other.fftw_in);
+    std::swap(fftw_out, other.fftw_out);
+    std::swap(ifftw_out, other.ifftw_out);
+    magnitudes.swap(other.magnitudes);
+    std::swap(ring, other.ring);
+    std::swap(write_pos, other.write_pos);
+    std::swap(filled, other.filled);
+    std::swap(since_fft, other.since_fft);
+    std::swap(hop_size, other.hop_size);
+    std::swap(window_type, other.window_type);
+    std::swap(window, other.window);
+    std::swap(ready, other.ready);
 }
 
-bool FFTAnalyzer::addSample(float sample) {
-    if (sample_count < FFT_SIZE) {
-        fftw_in[sample_count] = (double)sample;
-        sample_count++;
-        ready = false;
+bool FFTAnalyzer::prepare(int size) {
+    if (size < MIN_FFT_SIZE || size > MAX_FFT_SIZE) {
+        return false;
+    }
+    FFTPlanCache::get(size);
+    return true;
+}
+
+void FFTAnalyzer::freeBuffers() {
+    fftwf_free(fftw_in);
+    fftwf_free(fftw_out);
+    fftwf_free(ifftw_out);
+    fftwf_free(ring);
+    fftwf_free(window);
+    fftw_in = nullptr;
+    fftw_out = nullptr;
+    ifftw_out = nullptr;
+    ring = nullptr;
+    window = nullptr;
+}
+
+void FFTAnalyzer::setHopSize(int hop) {
+    hop_size = std::max(0, hop);
+    reset();
+}
+
+void FFTAnalyzer::setWindow(WindowType type) {
+    window_type = type;
+    fillWindow(window_type, window, fft_size);
+}
+
+void FFTAnalyzer::fillWindow(WindowType type, float* window, int size) {
+    // Periodic forms (denominator size), which is what spectral
+    // analysis with overlap wants
+    const double step = 2.0 * M_PI / size;
+    double sum = 0.0;
+    for (int i = 0; i < size; i++) {
+        double w = 1.0;
+        switch (type) {
+            case WindowType::Rectangular:
+                break;
+            case WindowType::Hann:
+                w = 0.5 - 0.5 * cos(step * i);
+                break;
+            case WindowType::BlackmanHarris:
+                w = 0.35875 - 0.48829 * cos(step * i) + 0.14128 * cos(2.0 * step * i)
+                    - 0.01168 * cos(3.0 * step * i);
+                break;
+        }
+        window[i] = (float)w;
+        sum += w;
     }
+
+    // Unit mean (coherent gain 1) keeps magnitudes comparable across windows
+    float scale = (float)(size / sum);
+    for (int i = 0; i < size; i++) {
+        window[i] *= scale;
+    }
+}
+
+bool FFTAnalyzer::addSample(float sample) {
+    ring[write_pos] = sample;
+    ring[write_pos + fft_size] = sample;
+    write_pos = (write_pos + 1 == fft_size) ? 0 : write_pos + 1;
+    filled = std::min(filled + 1, fft_size);
+    since_fft++;
+    ready = false;
     
-    // When buffer is full, compute FFT
-    if (sample_count == FFT_SIZE) {
+    // Once the ring is full, transform its latest fft_size samples every hop
+    if (filled == fft_size && since_fft >= getHopSize()) {
+        const float* frame = ring + write_pos; // Oldest sample first
+        if (window_type == WindowType::Rectangular) {
+            memcpy(fftw_in, frame, sizeof(float) * fft_size);
+        } else {
+            applyWindow(frame, window, fftw_in, fft_size);
+        }
         computeFFT();
-        sample_count = 0;
+        since_fft = 0;
         ready = true;
         return true;
     }
@@ -49,60 +162,70 @@ bool FFTAnalyzer::addSample(float sample) {
 }
 
 void FFTAnalyzer::computeFFT() {
-    // Execute FFT
-    fftw_execute(fftw_plan);
+    // Execute FFT with the shared plan on this analyzer's buffers (the
+    // measured plan once the background planner has swapped it in)
+    fftwf_execute_dft_r2c(plans->forward.load(std::memory_order_acquire), fftw_in, fftw_out);
     
-    // Calculate magnitudes
-    for (int k = 0; k < (FFT_SIZE / 2 + 1); k++) {
-        float real = (float)fftw_out[k][0];
-        float imag = (float)fftw_out[k][1];
-        float magnitude = sqrtf(real * real + imag * imag);
-        magnitudes[k] = magnitude;
-    }
+    // Calculate magnitudes (or power / dB)
+    SimdKernels::complexToSpectrum(&fftw_out[0][0], magnitudes.data(), fft_size / 2 + 1, spectrum_scale);
 }
 
 void FFTAnalyzer::computeFFTFromBuffer(const float* buffer, int size) {
     // Copy buffer to FFT input (zero-pad if necessary)
-    int copySize = std::min(size, FFT_SIZE);
-    for (int i = 0; i < copySize; i++) {
-        fftw_in[i] = (double)buffer[i];
+    int copySize = std::max(0, std::min(size, fft_size));
+    if (window_type == WindowType::Rectangular) {
+        memcpy(fftw_in, buffer, sizeof(float) * copySize);
+    } else {
+        applyWindow(buffer, window, fftw_in, copySize);
     }
     // Zero-pad the rest
-    for (int i = copySize; i < FFT_SIZE; i++) {
-        fftw_in[i] = 0.0;
-    }
-    
-    // Execute FFT
-    fftw_execute(fftw_plan);
-    
-    // Calculate magnitudes
-    for (int k = 0; k < (FFT_SIZE / 2 + 1); k++) {
-        float real = (float)fftw_out[k][0];
-        float imag = (float)fftw_out[k][1];
-        float magnitude = sqrtf(real * real + imag * imag);
-        magnitudes[k] = magnitude;
-    }
+    memset(fftw_in + copySize, 0, sizeof(float) * (fft_size - copySize));
     
+    computeFFT();
     ready = true;
 }
 
 void FFTAnalyzer::performIFFT(std::vector<float>& output) {
     // Execute inverse FFT
-    fftw_execute(ifftw_plan_var);
+    fftwf_execute_dft_c2r(plans->inverse.load(std::memory_order_acquire), fftw_out, ifftw_out);
     
     // Normalize the output (IFFT in FFTW needs normalization)
-    output.resize(FFT_SIZE);
-    double scale = 1.0 / FFT_SIZE;
-    for (int i = 0; i < FFT_SIZE; i++) {
-        output[i] = (float)(ifftw_out[i] * scale);
+    output.resize(fft_size);
+    float scale = 1.0f / fft_size;
+    for (int i = 0; i < fft_size; i++) {
+        output[i] = ifftw_out[i] * scale;
     }
 }
 
 void FFTAnalyzer::reset() {
-    sample_count = 0;
+    write_pos = 0;
+    filled = 0;
+    since_fft = 0;
     ready = false;
-    memset(fftw_in, 0, sizeof(double) * FFT_SIZE);
-    memset(ifftw_out, 0, sizeof(double) * FFT_SIZE);
+    memset(fftw_in, 0, sizeof(float) * fft_size);
+    memset(ifftw_out, 0, sizeof(float) * fft_size);
     std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
 }
 
+double FFTAnalyzer::compareWithDoublePrecision() const {
+    // The out-of-place r2c plans leave fftw_in intact, so it still holds the
+    // frame behind magnitudes
+    int bins = fft_size / 2 + 1;
+    double* in = fftw_alloc_real(fft_size);
+    fftw_complex* out = fftw_alloc_complex(bins);
+    for (int i = 0; i < fft_size; i++) {
+        in[i] = fftw_in[i];
+    }
+    fftw_execute_dft_r2c(FFTPlanCache::getReference(fft_size), in, out);
+
+    double peak = 0.0;
+    double maxError = 0.0;
+    for (int k = 0; k < bins; k++) {
+        double reference = std::sqrt(out[k][0] * out[k][0] + out[k][1] * out[k][1]);
+        peak = std::max(peak, reference);
+        maxError = std::max(maxError, std::fabs(reference - (double)magnitudes[k]));
+    }
+    fftw_free(in);
+    fftw_free(out);
+    return peak > 0.0 ? maxError / peak : 0.0;
+}
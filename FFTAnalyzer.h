@@ -4,26 +4,72 @@
 #include <fftw3.h>
 #include <vector>
 #include <cmath>
-
-#define FFT_SIZE 1024
+#include "FFTPlanCache.h"
+#include "SimdKernels.h"
 
 class FFTAnalyzer {
 public:
-    FFTAnalyzer();
+    static constexpr int DEFAULT_FFT_SIZE = 1024;
+    static constexpr int MIN_FFT_SIZE = 256;
+    static constexpr int MAX_FFT_SIZE = 65536;
+
+    // Analysis window, normalized to unit mean so a full-scale sine keeps the
+    // same peak magnitude whichever is chosen
+    enum class WindowType {
+        Rectangular, // No window (leaks, but is exact for the IFFT path)
+        Hann,
+        BlackmanHarris // 4-term, ~92 dB sidelobes
+    };
+
+    explicit FFTAnalyzer(int fftSize = DEFAULT_FFT_SIZE);
     ~FFTAnalyzer();
+
+    FFTAnalyzer(const FFTAnalyzer&) = delete;
+    FFTAnalyzer& operator=(const FFTAnalyzer&) = delete;
+
+    // Exchange everything with other without allocating, so an analyzer
+    // set up elsewhere can be swapped in under a lock
+    void swap(FFTAnalyzer& other);
+    
+    // Change the transform size (MIN_FFT_SIZE..MAX_FFT_SIZE); clears the
+    // buffer
+    bool setFFTSize(int size);
+    int getFFTSize() const { return fft_size; }
+
+    // Plan a size without touching an analyzer, so that a setFFTSize()
+    // made under a lock does not wait on the planner
+    static bool prepare(int size);
+
+    // Samples between transforms in addSample (sliding STFT). 0, or anything
+    // above the FFT size, means one transform per full block of samples
+    // without overlap. Clears the buffer.
+    void setHopSize(int hop);
+    int getHopSize() const { return (hop_size > 0 && hop_size < fft_size) ? hop_size : fft_size; }
+
+    // Window applied to every transform (default Rectangular)
+    void setWindow(WindowType type);
+    WindowType getWindow() const { return window_type; }
+
+    // Fill size coefficients of a window (also used by BatchFFT)
+    static void fillWindow(WindowType type, float* window, int size);
     
-    // Process a single sample (returns true when FFT is ready)
+    // Process a single sample (returns true when FFT is ready): the latest
+    // getFFTSize() samples are transformed every getHopSize() samples
     bool addSample(float sample);
     
     // Compute FFT directly from a buffer (for audio filtering)
     void computeFFTFromBuffer(const float* buffer, int size);
     
-    // Get the latest FFT magnitudes (size: FFT_SIZE/2 + 1)
+    // Scale of getMagnitudes(): linear magnitude (default), power or dB
+    void setSpectrumScale(SimdKernels::SpectrumScale scale) { spectrum_scale = scale; }
+    SimdKernels::SpectrumScale getSpectrumScale() const { return spectrum_scale; }
+    
+    // Get the latest FFT magnitudes (size: getFFTSize()/2 + 1)
     const std::vector<float>& getMagnitudes() const { return magnitudes; }
     
     // Get the complex FFT output (for filtering and IFFT)
-    fftw_complex* getFFTOutput() { return fftw_out; }
-    const fftw_complex* getFFTOutput() const { return fftw_out; }
+    fftwf_complex* getFFTOutput() { return fftw_out; }
+    const fftwf_complex* getFFTOutput() const { return fftw_out; }
     
     // Perform inverse FFT on modified complex data and get time-domain samples
     void performIFFT(std::vector<float>& output);
@@ -34,18 +80,37 @@ public:
     // Check if FFT is ready
     bool isReady() const { return ready; }
 
+    // Redo the last transform in double precision and return the largest
+    // magnitude difference relative to the spectrum's peak (0 for silence).
+    // Diagnostic only: needs the Magnitude scale, and the input must not have
+    // changed since the FFT ran.
+    double compareWithDoublePrecision() const;
+
 private:
-    double* fftw_in;
-    fftw_complex* fftw_out;
-    double* ifftw_out; // Output buffer for IFFT
-    fftw_plan ifftw_plan_var; // Inverse FFT plan  
-    fftw_plan fftw_plan;
+    int fft_size;
+    const FFTPlanCache::Plans* plans; // Shared, owned by FFTPlanCache
+    SimdKernels::SpectrumScale spectrum_scale;
+    // Single precision throughout: samples go in and magnitudes come out as
+    // float, so no buffer needs converting
+    float* fftw_in;
+    fftwf_complex* fftw_out;
+    float* ifftw_out; // Output buffer for IFFT
     std::vector<float> magnitudes;
-    int sample_count;
+
+    // Sliding input: each sample is written at write_pos and write_pos +
+    // fft_size, so the latest fft_size samples are always contiguous at
+    // ring + write_pos and a hop only costs the windowing pass
+    float* ring;
+    int write_pos;
+    int filled;       // Valid samples in the ring, up to fft_size
+    int since_fft;    // Samples added since the last transform
+    int hop_size;     // As set; see getHopSize()
+    WindowType window_type;
+    float* window;    // fft_size coefficients
     bool ready;
     
     void computeFFT();
+    void freeBuffers();
 };
 
 #endif // FFTANALYZER_H
-
@@ -0,0 +1,276 @@
+#include "FFTPlanCache.h"
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Rigor of the plans measured in the background. Wisdom made with a higher
+// rigor (FFTW_PATIENT, e.g. from fftwf-wisdom) satisfies it as well.
+constexpr unsigned int MEASURED_FLAGS = FFTW_MEASURE;
+
+std::string defaultWisdomFile() {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) {
+        return std::string(xdg) + "/audio_visualizer/fftwf.wisdom";
+    } else if (home && *home) {
+        return std::string(home) + "/.cache/audio_visualizer/fftwf.wisdom";
+    }
+    return std::string();
+}
+
+// Everything below is guarded by FFTPlanCache::plannerMutex(), except the
+// single-transform plans map and the measure queue. Those have their own
+// locks, held only briefly, so get() for a planned size never waits on a
+// measurement.
+struct PlanStore {
+    std::mutex plans_mutex;
+    std::map<int, FFTPlanCache::Plans> plans; // Entries never move or go away
+    std::map<std::pair<int, int>, fftwf_plan> batch_plans; // (size, count)
+    std::map<int, fftw_plan> reference_plans;
+    std::vector<fftwf_plan> retired; // Replaced plans, possibly still executing
+    std::string wisdom_file = defaultWisdomFile();
+    bool wisdom_loaded = false;
+    bool wisdom_dirty = false;
+
+    std::thread measure_thread;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::deque<int> measure_queue;
+    bool stop = false;
+
+    ~PlanStore() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stop = true;
+            measure_queue.clear();
+        }
+        queue_cv.notify_all();
+        if (measure_thread.joinable()) {
+            measure_thread.join();
+        }
+
+        for (auto& entry : plans) {
+            fftwf_destroy_plan(entry.second.forward.load());
+            fftwf_destroy_plan(entry.second.inverse.load());
+        }
+        for (auto& entry : batch_plans) {
+            fftwf_destroy_plan(entry.second);
+        }
+        for (fftwf_plan plan : retired) {
+            fftwf_destroy_plan(plan);
+        }
+        for (auto& entry : reference_plans) {
+            fftw_destroy_plan(entry.second);
+        }
+    }
+
+    void loadWisdom() {
+        wisdom_loaded = true;
+        std::error_code ec;
+        if (wisdom_file.empty() || !fs::exists(wisdom_file, ec)) {
+            return;
+        }
+        if (!fftwf_import_wisdom_from_filename(wisdom_file.c_str())) {
+            std::cerr << "Ignoring unreadable FFTW wisdom: " << wisdom_file << std::endl;
+        }
+    }
+
+    // Plan a forward/inverse pair on scratch arrays; both null on failure
+    static bool makePlans(int size, unsigned int flags, fftwf_plan& forward, fftwf_plan& inverse) {
+        float* in = fftwf_alloc_real(size);
+        fftwf_complex* out = fftwf_alloc_complex(size / 2 + 1);
+        forward = fftwf_plan_dft_r2c_1d(size, in, out, flags);
+        inverse = fftwf_plan_dft_c2r_1d(size, out, in, flags);
+        fftwf_free(in);
+        fftwf_free(out);
+        if (!forward || !inverse) {
+            if (forward) fftwf_destroy_plan(forward);
+            if (inverse) fftwf_destroy_plan(inverse);
+            forward = nullptr;
+            inverse = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void queueMeasure(int size) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            measure_queue.push_back(size);
+            if (!measure_thread.joinable()) {
+                measure_thread = std::thread(&PlanStore::measureLoop, this);
+            }
+        }
+        queue_cv.notify_one();
+    }
+
+    void measureLoop() {
+        for (;;) {
+            int size;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this] { return stop || !measure_queue.empty(); });
+                if (stop) {
+                    return;
+                }
+                size = measure_queue.front();
+                measure_queue.pop_front();
+            }
+
+            // Holds the planner for the whole measurement (milliseconds up to
+            // ~1 s at 64k); get() for an unplanned size waits that long
+            std::lock_guard<std::mutex> lock(FFTPlanCache::plannerMutex());
+            fftwf_plan forward, inverse;
+            if (!makePlans(size, MEASURED_FLAGS, forward, inverse)) {
+                continue;
+            }
+            FFTPlanCache::Plans* entry;
+            {
+                std::lock_guard<std::mutex> plansLock(plans_mutex);
+                entry = &plans[size];
+            }
+            FFTPlanCache::Plans& current = *entry;
+            retired.push_back(current.forward.exchange(forward, std::memory_order_acq_rel));
+            retired.push_back(current.inverse.exchange(inverse, std::memory_order_acq_rel));
+            wisdom_dirty = true;
+        }
+    }
+};
+
+PlanStore& store() {
+    static PlanStore instance;
+    return instance;
+}
+
+} // namespace
+
+std::mutex& FFTPlanCache::plannerMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+const FFTPlanCache::Plans& FFTPlanCache::get(int size) {
+    PlanStore& cache = store();
+    {
+        std::lock_guard<std::mutex> plansLock(cache.plans_mutex);
+        auto it = cache.plans.find(size);
+        if (it != cache.plans.end()) {
+            return it->second;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    {
+        // Another thread may have planned it while we waited
+        std::lock_guard<std::mutex> plansLock(cache.plans_mutex);
+        auto it = cache.plans.find(size);
+        if (it != cache.plans.end()) {
+            return it->second;
+        }
+    }
+    if (!cache.wisdom_loaded) {
+        cache.loadWisdom();
+    }
+
+    // A measured plan from wisdom costs no more than an estimate; without
+    // one, start with an estimate and measure in the background
+    fftwf_plan forward, inverse;
+    bool measured = PlanStore::makePlans(size, MEASURED_FLAGS | FFTW_WISDOM_ONLY, forward, inverse);
+    if (!measured) {
+        PlanStore::makePlans(size, FFTW_ESTIMATE, forward, inverse);
+    }
+
+    std::unique_lock<std::mutex> plansLock(cache.plans_mutex);
+    Plans& plans = cache.plans[size];
+    plans.forward.store(forward, std::memory_order_release);
+    plans.inverse.store(inverse, std::memory_order_release);
+    plansLock.unlock();
+    if (!measured) {
+        cache.queueMeasure(size);
+    }
+    return plans;
+}
+
+fftwf_plan FFTPlanCache::getBatch(int size, int count) {
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    PlanStore& cache = store();
+    auto it = cache.batch_plans.find(std::make_pair(size, count));
+    if (it != cache.batch_plans.end()) {
+        return it->second;
+    }
+    if (!cache.wisdom_loaded) {
+        cache.loadWisdom();
+    }
+
+    int bins = size / 2 + 1;
+    float* in = fftwf_alloc_real((size_t)size * count);
+    fftwf_complex* out = fftwf_alloc_complex((size_t)bins * count);
+    fftwf_plan plan = fftwf_plan_many_dft_r2c(1, &size, count, in, nullptr, 1, size,
+                                              out, nullptr, 1, bins, MEASURED_FLAGS | FFTW_WISDOM_ONLY);
+    if (!plan) {
+        plan = fftwf_plan_many_dft_r2c(1, &size, count, in, nullptr, 1, size,
+                                       out, nullptr, 1, bins, FFTW_ESTIMATE);
+    }
+    fftwf_free(in);
+    fftwf_free(out);
+
+    return cache.batch_plans.emplace(std::make_pair(size, count), plan).first->second;
+}
+
+fftw_plan FFTPlanCache::getReference(int size) {
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    PlanStore& cache = store();
+    auto it = cache.reference_plans.find(size);
+    if (it != cache.reference_plans.end()) {
+        return it->second;
+    }
+
+    double* in = fftw_alloc_real(size);
+    fftw_complex* out = fftw_alloc_complex(size / 2 + 1);
+    fftw_plan plan = fftw_plan_dft_r2c_1d(size, in, out, FFTW_ESTIMATE);
+    fftw_free(in);
+    fftw_free(out);
+
+    return cache.reference_plans.emplace(size, plan).first->second;
+}
+
+void FFTPlanCache::setWisdomFile(const std::string& path) {
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    PlanStore& cache = store();
+    cache.wisdom_file = path;
+    cache.wisdom_loaded = false;
+}
+
+bool FFTPlanCache::saveWisdom() {
+    std::lock_guard<std::mutex> lock(plannerMutex());
+    PlanStore& cache = store();
+    if (!cache.wisdom_dirty || cache.wisdom_file.empty()) {
+        return true;
+    }
+
+    // Write a temporary file and rename it, so concurrent instances never
+    // read half-written wisdom
+    fs::path path(cache.wisdom_file);
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    std::string tmpPath = cache.wisdom_file + ".tmp." + std::to_string(getpid());
+    if (!fftwf_export_wisdom_to_filename(tmpPath.c_str()) ||
+        rename(tmpPath.c_str(), cache.wisdom_file.c_str()) != 0) {
+        std::cerr << "Failed to save FFTW wisdom: " << cache.wisdom_file << std::endl;
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+    cache.wisdom_dirty = false;
+    return true;
+}
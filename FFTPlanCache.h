@@ -0,0 +1,59 @@
+#ifndef FFTPLANCACHE_H
+#define FFTPLANCACHE_H
+
+#include <fftw3.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Process-wide cache of FFTW plans, one forward/inverse pair per transform
+// size. Planning is the slow and non-thread-safe part of FFTW, so each size
+// is planned once; analyzers run the shared plans on their own buffers via
+// the new-array execute functions (fftwf_malloc gives every buffer the
+// alignment the plans were made with).
+//
+// Plans come from FFTW wisdom when the wisdom file has a measured plan for
+// the size. Otherwise an FFTW_ESTIMATE plan is returned at once and a
+// background thread measures a faster one, which replaces it in place; the
+// new wisdom is written back by saveWisdom.
+class FFTPlanCache {
+public:
+    // Single-precision plans, used for all analysis. Load the plan at each
+    // execute: a measured plan may be swapped in at any time, and the one it
+    // replaces stays valid until exit.
+    struct Plans {
+        std::atomic<fftwf_plan> forward; // Real to complex, size -> size/2 + 1
+        std::atomic<fftwf_plan> inverse; // Complex to real (overwrites its input)
+    };
+
+    // Get the plans for a transform size, planning on first use. Thread-safe;
+    // the plans stay valid until the process exits. A planned size is a
+    // quick lookup, but planning a new one waits while a background
+    // measurement holds the planner (up to ~1 s), so do that ahead of any
+    // lock the audio callback takes.
+    static const Plans& get(int size);
+
+    // Forward plan transforming count frames at once (fftwf_plan_many_dft_r2c)
+    // from a count x size real matrix into a count x (size/2 + 1) complex
+    // one, both rows contiguous. Used from wisdom when available, otherwise
+    // estimated; batches are not measured in the background.
+    static fftwf_plan getBatch(int size, int count);
+
+    // Double-precision forward plan for the same size, kept only as the
+    // reference that float results are checked against
+    static fftw_plan getReference(int size);
+
+    // Wisdom file read before the first plan is made; defaults to
+    // $XDG_CACHE_HOME/audio_visualizer/fftwf.wisdom (or ~/.cache/...). An
+    // empty path disables loading and saving.
+    static void setWisdomFile(const std::string& path);
+
+    // Write the accumulated wisdom back if any plan was measured since it
+    // was loaded. Call once on exit.
+    static bool saveWisdom();
+
+    // Held around every FFTW planner call (plan creation and destruction)
+    static std::mutex& plannerMutex();
+};
+
+#endif // FFTPLANCACHE_H
@@ -0,0 +1,175 @@
+#include "FirFilter.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Crossover benchmark: a second of audio at 16 kHz in callback-sized
+// blocks, at doubling tap counts
+constexpr int BENCHMARK_SAMPLES = 16384;
+constexpr int BENCHMARK_BLOCK = 512;
+constexpr int MIN_BENCHMARK_TAPS = 16;
+constexpr int MAX_BENCHMARK_TAPS = 8192;
+
+// Best of a few passes, so a background plan measurement competing for
+// the CPU (each new transform size queues one) does not decide the result
+constexpr int BENCHMARK_RUNS = 3;
+
+double timeEngine(FirFilter::Engine engine, int taps, const std::vector<float>& input,
+                  std::vector<float>& output) {
+    // Set up (plans included) before the clock starts
+    FirFilter filter;
+    filter.setEngine(engine);
+    filter.setChannelCount(1);
+    filter.setCoefficients(std::vector<float>(taps, 1.0f / taps));
+    double best = 0.0;
+    for (int run = 0; run < BENCHMARK_RUNS; run++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < input.size(); i += BENCHMARK_BLOCK) {
+            size_t count = std::min((size_t)BENCHMARK_BLOCK, input.size() - i);
+            filter.process(input.data() + i, output.data() + i, count, 0);
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = (run == 0) ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+int measureCrossover() {
+    std::vector<float> input(BENCHMARK_SAMPLES);
+    std::vector<float> output(BENCHMARK_SAMPLES);
+    unsigned int seed = 1;
+    for (float& sample : input) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = (float)(seed >> 8) / (1 << 24) - 0.5f;
+    }
+    for (int taps = MIN_BENCHMARK_TAPS; taps <= MAX_BENCHMARK_TAPS; taps *= 2) {
+        if (timeEngine(FirFilter::Engine::OverlapSave, taps, input, output) <
+            timeEngine(FirFilter::Engine::Direct, taps, input, output)) {
+            return taps;
+        }
+    }
+    return 2 * MAX_BENCHMARK_TAPS;
+}
+
+} // namespace
+
+FirFilter::FirFilter()
+    : engine(Engine::Auto), use_convolver(false), channel_count(0) {
+}
+
+int FirFilter::getCrossoverTaps() {
+    static const int crossover = measureCrossover();
+    return crossover;
+}
+
+void FirFilter::setEngine(Engine newEngine) {
+    engine = newEngine;
+    selectEngine();
+}
+
+void FirFilter::selectEngine() {
+    const int taps = (int)coefficients.size();
+    switch (engine) {
+    case Engine::Auto:
+        use_convolver = taps > 0 && taps >= getCrossoverTaps();
+        break;
+    case Engine::Direct:
+        use_convolver = false;
+        break;
+    case Engine::OverlapSave:
+        use_convolver = taps > 0;
+        break;
+    }
+    convolver.setCoefficients(use_convolver ? coefficients : std::vector<float>());
+    convolver.reset();
+    resizeHistories();
+}
+
+void FirFilter::setCoefficients(const std::vector<float>& coeffs) {
+    bool resize = coeffs.size() != coefficients.size();
+    coefficients = coeffs;
+    reversed.assign(coeffs.rbegin(), coeffs.rend());
+    if (resize) {
+        selectEngine();
+    } else if (use_convolver) {
+        convolver.setCoefficients(coefficients);
+    }
+}
+
+void FirFilter::setChannelCount(unsigned int channels) {
+    if (channels == channel_count) {
+        return;
+    }
+    channel_count = channels;
+    histories.resize(channels);
+    resizeHistories();
+    convolver.setChannelCount(channels);
+}
+
+void FirFilter::resizeHistories() {
+    const size_t length = use_convolver ? 0 : 2 * coefficients.size();
+    for (History& history : histories) {
+        history.samples.assign(length, 0.0f);
+        history.pos = 0;
+    }
+}
+
+void FirFilter::reset() {
+    for (History& history : histories) {
+        std::fill(history.samples.begin(), history.samples.end(), 0.0f);
+        history.pos = 0;
+    }
+    convolver.reset();
+}
+
+bool FirFilter::copyStateFrom(const FirFilter& other) {
+    if (other.coefficients.size() != coefficients.size() || other.use_convolver != use_convolver ||
+        other.channel_count != channel_count) {
+        return false;
+    }
+    if (use_convolver) {
+        return convolver.copyStateFrom(other.convolver);
+    }
+    for (unsigned int ch = 0; ch < channel_count; ch++) {
+        std::copy(other.histories[ch].samples.begin(), other.histories[ch].samples.end(),
+                  histories[ch].samples.begin());
+        histories[ch].pos = other.histories[ch].pos;
+    }
+    return true;
+}
+
+void FirFilter::process(const float* in, float* out, size_t count, unsigned int channel) {
+    if (coefficients.empty() || channel >= channel_count) {
+        if (out != in) {
+            std::memmove(out, in, count * sizeof(float));
+        }
+        return;
+    }
+    if (use_convolver) {
+        convolver.process(in, out, count, channel);
+        return;
+    }
+
+    const int taps = (int)coefficients.size();
+    const float* h = reversed.data();
+    float* samples = histories[channel].samples.data();
+    int pos = histories[channel].pos;
+
+    for (size_t i = 0; i < count; i++) {
+        // After the write the newest sample sits at pos + taps, so the
+        // window of the latest taps samples starts at pos + 1
+        float sample = in[i];
+        samples[pos] = sample;
+        samples[pos + taps] = sample;
+        float output = SimdKernels::dotProduct(h, samples + pos + 1, taps);
+        pos = (pos + 1 == taps) ? 0 : pos + 1;
+
+        // Safety check: prevent NaN/Inf
+        out[i] = std::isfinite(output) ? output : 0.0f;
+    }
+    histories[channel].pos = pos;
+}
@@ -0,0 +1,84 @@
+#ifndef FIRFILTER_H
+#define FIRFILTER_H
+
+#include <vector>
+#include <cstddef>
+#include "OverlapSaveConvolver.h"
+
+// One FIR filter applied to several independent channels, a block at a time.
+//
+// Short kernels run directly: each channel keeps its input history in a
+// circular buffer of twice the tap count, with every sample written at pos
+// and pos + taps. The latest taps samples are then always contiguous, so an
+// output is one SIMD dot product (SimdKernels::dotProduct) against the
+// reversed coefficients. Long kernels, from getCrossoverTaps() up, go
+// through an OverlapSaveConvolver instead, at the price of one block of
+// extra latency.
+class FirFilter {
+public:
+    enum class Engine {
+        Auto,       // Direct below getCrossoverTaps(), overlap-save from there
+        Direct,
+        OverlapSave
+    };
+
+    FirFilter();
+
+    // Tap count from which overlap-save beats the direct form on this
+    // machine, benchmarked once on first use (takes a few milliseconds)
+    static int getCrossoverTaps();
+
+    // Force an engine (default Auto); clears the channel histories
+    void setEngine(Engine engine);
+    Engine getEngine() const { return engine; }
+
+    // Whether the current coefficients run through overlap-save
+    bool usesConvolver() const { return use_convolver; }
+
+    // Samples of delay added by the engine (not counting the filter's own)
+    int getLatency() const { return use_convolver ? convolver.getLatency() : 0; }
+
+    // Taps in convolution order (coeffs[0] weights the newest sample).
+    // Histories are kept if the length is unchanged and cleared otherwise.
+    void setCoefficients(const std::vector<float>& coeffs);
+    const std::vector<float>& getCoefficients() const { return coefficients; }
+    int getTaps() const { return (int)coefficients.size(); }
+    bool empty() const { return coefficients.empty(); }
+
+    // Number of channels with their own history; new channels start silent
+    void setChannelCount(unsigned int channels);
+    unsigned int getChannelCount() const { return channel_count; }
+
+    // Filter count samples of one channel. in and out may be the same
+    // buffer. Without coefficients (or for an unknown channel) the input is
+    // passed through.
+    void process(const float* in, float* out, size_t count, unsigned int channel);
+
+    // Zero every channel's history
+    void reset();
+
+    // Take over other's channel histories if it runs the same engine with
+    // the same tap and channel counts. The direct form's history is just
+    // past input, so it is then exactly primed for the new coefficients.
+    // Returns false, changing nothing, otherwise.
+    bool copyStateFrom(const FirFilter& other);
+
+private:
+    struct History {
+        std::vector<float> samples; // 2 x taps, mirrored
+        int pos;                    // Next write index in [0, taps)
+    };
+
+    Engine engine;
+    bool use_convolver;
+    unsigned int channel_count;
+    std::vector<float> coefficients;
+    std::vector<float> reversed; // Oldest-first, to match the history window
+    std::vector<History> histories; // Direct form only
+    OverlapSaveConvolver convolver;
+
+    void selectEngine();
+    void resizeHistories();
+};
+
+#endif // FIRFILTER_H
@@ -1,4 +1,5 @@
 #include "FrequencyFilter.h"
+#include "FFTPlanCache.h"
 #include <cstring>
 #include <cmath>
 
@@ -8,15 +9,41 @@ FrequencyFilter::FrequencyFilter()
       lowPassCutoff(0.0f), highPassCutoff(0.0f),
       bandStopLow(0.0f), bandStopHigh(0.0f),
       bandPassLow(0.0f), bandPassHigh(0.0f),
-      currentSampleRate(44100.0f) {
-    // Initialize delay lines to match default filter length (257)
-    lowPassDelayLine.resize(257, 0.0f);
-    highPassDelayLine.resize(257, 0.0f);
-    bandStopDelayLine.resize(257, 0.0f);
-    bandPassDelayLine.resize(257, 0.0f);
+      currentSampleRate(44100.0f), channelCount(0),
+      backend(Backend::FIR), iirResponse(BiquadCascade::Response::Butterworth),
+      cascade(new Cascade()), incoming(nullptr), transitionFadeIn(0), transitionCrossfade(true),
+      outputDelay(0),
+      transitionInput(TRANSITION_CHUNK), transitionOutput(TRANSITION_CHUNK),
+      pendingCascade(nullptr), retiredCascades(nullptr) {
+    setChannelCount(1);
+}
+
+FrequencyFilter::FrequencyFilter(const FrequencyFilter& other)
+    : lowPassEnabled(other.lowPassEnabled.load()), highPassEnabled(other.highPassEnabled.load()),
+      bandStopEnabled(other.bandStopEnabled.load()), bandPassEnabled(other.bandPassEnabled.load()),
+      lowPassCutoff(other.lowPassCutoff.load()), highPassCutoff(other.highPassCutoff.load()),
+      bandStopLow(other.bandStopLow.load()), bandStopHigh(other.bandStopHigh.load()),
+      bandPassLow(other.bandPassLow.load()), bandPassHigh(other.bandPassHigh.load()),
+      currentSampleRate(other.currentSampleRate), channelCount(0),
+      backend(other.backend), iirResponse(other.iirResponse),
+      lowPassCoeffs(other.lowPassCoeffs), highPassCoeffs(other.highPassCoeffs),
+      bandStopCoeffs(other.bandStopCoeffs), bandPassCoeffs(other.bandPassCoeffs),
+      lowPassSections(other.lowPassSections), highPassSections(other.highPassSections),
+      bandStopSections(other.bandStopSections), bandPassSections(other.bandPassSections),
+      cascade(new Cascade()), incoming(nullptr), transitionFadeIn(0), transitionCrossfade(true),
+      outputDelay(0),
+      transitionInput(TRANSITION_CHUNK), transitionOutput(TRANSITION_CHUNK),
+      pendingCascade(nullptr), retiredCascades(nullptr) {
+    setChannelCount(other.channelCount);
+    compileCascade();
+    adoptLatest();
 }
 
 FrequencyFilter::~FrequencyFilter() {
+    delete cascade;
+    delete incoming;
+    delete pendingCascade.exchange(nullptr);
+    deleteRetired();
 }
 
 void FrequencyFilter::setLowPassCutoff(float cutoffHz, float sampleRate) {
@@ -24,8 +51,10 @@ void FrequencyFilter::setLowPassCutoff(float cutoffHz, float sampleRate) {
     currentSampleRate = sampleRate;
     if (cutoffHz > 0 && cutoffHz < sampleRate / 2) {
         generateLowPassCoeffs(cutoffHz, sampleRate);
-        // Reset delay line when parameters change to avoid transients
-        std::fill(lowPassDelayLine.begin(), lowPassDelayLine.end(), 0.0f);
+        designSections();
+        if (lowPassEnabled) {
+            compileCascade();
+        }
     }
 }
 
@@ -34,8 +63,10 @@ void FrequencyFilter::setHighPassCutoff(float cutoffHz, float sampleRate) {
     currentSampleRate = sampleRate;
     if (cutoffHz > 0 && cutoffHz < sampleRate / 2) {
         generateHighPassCoeffs(cutoffHz, sampleRate);
-        // Reset delay line when parameters change to avoid transients
-        std::fill(highPassDelayLine.begin(), highPassDelayLine.end(), 0.0f);
+        designSections();
+        if (highPassEnabled) {
+            compileCascade();
+        }
     }
 }
 
@@ -45,8 +76,10 @@ void FrequencyFilter::setBandStop(float lowHz, float highHz, float sampleRate) {
     currentSampleRate = sampleRate;
     if (lowHz > 0 && highHz > lowHz && highHz < sampleRate / 2) {
         generateBandStopCoeffs(lowHz, highHz, sampleRate);
-        // Reset delay line when parameters change to avoid transients
-        std::fill(bandStopDelayLine.begin(), bandStopDelayLine.end(), 0.0f);
+        designSections();
+        if (bandStopEnabled) {
+            compileCascade();
+        }
     }
 }
 
@@ -56,37 +89,400 @@ void FrequencyFilter::setBandPass(float lowHz, float highHz, float sampleRate) {
     currentSampleRate = sampleRate;
     if (lowHz > 0 && highHz > lowHz && highHz < sampleRate / 2) {
         generateBandPassCoeffs(lowHz, highHz, sampleRate);
-        // Reset delay line when parameters change to avoid transients
-        std::fill(bandPassDelayLine.begin(), bandPassDelayLine.end(), 0.0f);
+        designSections();
+        if (bandPassEnabled) {
+            compileCascade();
+        }
+    }
+}
+
+void FrequencyFilter::enableLowPass(bool enabled) {
+    if (enabled != lowPassEnabled) {
+        lowPassEnabled = enabled;
+        compileCascade();
+    }
+}
+
+void FrequencyFilter::enableHighPass(bool enabled) {
+    if (enabled != highPassEnabled) {
+        highPassEnabled = enabled;
+        compileCascade();
+    }
+}
+
+void FrequencyFilter::enableBandStop(bool enabled) {
+    if (enabled != bandStopEnabled) {
+        bandStopEnabled = enabled;
+        compileCascade();
+    }
+}
+
+void FrequencyFilter::enableBandPass(bool enabled) {
+    if (enabled != bandPassEnabled) {
+        bandPassEnabled = enabled;
+        compileCascade();
     }
 }
 
-float FrequencyFilter::processSample(float sample) {
+void FrequencyFilter::setBackend(Backend newBackend, BiquadCascade::Response response) {
+    if (newBackend == backend && response == iirResponse) {
+        return;
+    }
+    backend = newBackend;
+    if (response != iirResponse) {
+        iirResponse = response;
+        designSections();
+    }
+    compileCascade();
+}
+
+void FrequencyFilter::setChannelCount(unsigned int channels) {
+    if (channels == 0 || channels == channelCount) {
+        return;
+    }
+    channelCount = channels;
+    
+    // New channels start with a silent history
+    adoptLatest();
+    cascade->setChannelCount(channels);
+    transitionPos.assign(channels, 0);
+}
+
+float FrequencyFilter::processSample(float sample, unsigned int channel) {
     float output = sample;
+    processBlock(&sample, &output, 1, channel);
+    return output;
+}
+
+void FrequencyFilter::processBlock(const float* in, float* out, size_t count, unsigned int channel) {
+    // One cascade for all enabled filters (passes through when none is)
+    pickUpCascade();
+    if (incoming) {
+        processTransition(in, out, count, channel);
+        finishTransition();
+    } else {
+        cascade->process(in, out, count, channel);
+    }
+    clampSamples(out, count);
+}
+
+void FrequencyFilter::processChannels(float* const* data, unsigned int channels, size_t count) {
+    pickUpCascade();
+    if (incoming) {
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            processTransition(data[ch], data[ch], count, ch);
+        }
+        finishTransition();
+    } else {
+        cascade->processChannels(data, channels, count);
+    }
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        clampSamples(data[ch], count);
+    }
+}
+
+void FrequencyFilter::pickUpCascade() {
+    // One crossfade at a time; anything published meanwhile waits (only
+    // the latest is kept)
+    if (incoming || !pendingCascade.load(std::memory_order_relaxed)) {
+        return;
+    }
+    incoming = pendingCascade.exchange(nullptr, std::memory_order_acquire);
+    if (!incoming) {
+        return;
+    }
+    bool primed = incoming->copyStateFrom(*cascade);
+    size_t settle = incoming->settleSamples(primed);
+    transitionCrossfade = incoming->delaySamples() == cascade->delaySamples();
+    transitionFadeIn = transitionCrossfade ? settle : std::max(settle, (size_t)CROSSFADE_SAMPLES);
+    std::fill(transitionPos.begin(), transitionPos.end(), 0);
+}
+
+void FrequencyFilter::processTransition(const float* in, float* out, size_t count, unsigned int channel) {
+    if (channel >= transitionPos.size()) {
+        cascade->process(in, out, count, channel);
+        return;
+    }
+    
+    // Both cascades run on the same input, the incoming one settling while
+    // the outgoing one is heard. With equal delays the two outputs are
+    // strongly correlated, so a linear crossfade keeps the level. With
+    // different delays they are not the same moment of the signal, so the
+    // old output fades out before the new one fades in.
+    size_t& pos = transitionPos[channel];
+    while (count > 0) {
+        size_t n = std::min(count, TRANSITION_CHUNK);
+        std::memcpy(transitionInput.data(), in, n * sizeof(float)); // in may alias out
+        cascade->process(transitionInput.data(), out, n, channel);
+        incoming->process(transitionInput.data(), transitionOutput.data(), n, channel);
+        for (size_t i = 0; i < n; i++, pos++) {
+            float fadeIn = 0.0f;
+            if (pos >= transitionFadeIn) {
+                size_t faded = pos - transitionFadeIn + 1;
+                fadeIn = (faded >= (size_t)CROSSFADE_SAMPLES) ? 1.0f : (float)faded / CROSSFADE_SAMPLES;
+            }
+            float fadeOut = 1.0f - fadeIn;
+            if (!transitionCrossfade) {
+                size_t left = (pos < transitionFadeIn) ? transitionFadeIn - pos : 0;
+                fadeOut = (left >= (size_t)CROSSFADE_SAMPLES) ? 1.0f : (float)left / CROSSFADE_SAMPLES;
+            }
+            out[i] = fadeOut * out[i] + fadeIn * transitionOutput[i];
+        }
+        in += n;
+        out += n;
+        count -= n;
+    }
+}
+
+void FrequencyFilter::finishTransition() {
+    for (size_t pos : transitionPos) {
+        if (pos < transitionFadeIn + CROSSFADE_SAMPLES) {
+            return;
+        }
+    }
     
-    // Apply filters in sequence (order matters for combined filters)
-    if (bandPassEnabled && !bandPassCoeffs.empty()) {
-        output = applyFIR(bandPassCoeffs, bandPassDelayLine, output);
+    // Deleting is not real-time safe, so the outgoing cascade goes back to
+    // the control side
+    Cascade* retired = cascade;
+    retired->nextRetired = retiredCascades.load(std::memory_order_relaxed);
+    while (!retiredCascades.compare_exchange_weak(retired->nextRetired, retired,
+                                                  std::memory_order_release,
+                                                  std::memory_order_relaxed)) {
+    }
+    cascade = incoming;
+    incoming = nullptr;
+    outputDelay.store(cascade->delaySamples(), std::memory_order_relaxed);
+}
+
+void FrequencyFilter::publishCascade(Cascade* compiled) {
+    deleteRetired();
+    // One the audio side has not picked up yet is simply replaced
+    delete pendingCascade.exchange(compiled, std::memory_order_acq_rel);
+}
+
+void FrequencyFilter::deleteRetired() {
+    Cascade* retired = retiredCascades.exchange(nullptr, std::memory_order_acquire);
+    while (retired) {
+        Cascade* next = retired->nextRetired;
+        delete retired;
+        retired = next;
+    }
+}
+
+void FrequencyFilter::adoptLatest() {
+    if (incoming) {
+        delete cascade;
+        cascade = incoming;
+        incoming = nullptr;
+    }
+    Cascade* pending = pendingCascade.exchange(nullptr, std::memory_order_acquire);
+    if (pending) {
+        delete cascade;
+        cascade = pending;
+    }
+    outputDelay.store(cascade->delaySamples(), std::memory_order_relaxed);
+    deleteRetired();
+}
+
+void FrequencyFilter::clampSamples(float* samples, size_t count) {
+    // Clamp output to prevent clipping and distortion
+    // Audio samples should be in range [-1.0, 1.0]
+    for (size_t i = 0; i < count; i++) {
+        samples[i] = std::min(1.0f, std::max(-1.0f, samples[i]));
+    }
+}
+
+void FrequencyFilter::designSections() {
+    float nyquist = currentSampleRate / 2;
+    if (lowPassCutoff > 0 && lowPassCutoff < nyquist) {
+        lowPassSections = BiquadCascade::lowPass(lowPassCutoff, currentSampleRate, IIR_ORDER, iirResponse);
+    }
+    if (highPassCutoff > 0 && highPassCutoff < nyquist) {
+        highPassSections = BiquadCascade::highPass(highPassCutoff, currentSampleRate, IIR_ORDER, iirResponse);
+    }
+    if (bandStopLow > 0 && bandStopHigh > bandStopLow && bandStopHigh < nyquist) {
+        bandStopSections = BiquadCascade::bandStop(bandStopLow, bandStopHigh, currentSampleRate,
+                                                   IIR_BAND_ORDER, iirResponse);
+    }
+    if (bandPassLow > 0 && bandPassHigh > bandPassLow && bandPassHigh < nyquist) {
+        bandPassSections = BiquadCascade::bandPass(bandPassLow, bandPassHigh, currentSampleRate,
+                                                   IIR_BAND_ORDER, iirResponse);
+    }
+}
+
+void FrequencyFilter::compileCascade() {
+    Cascade* compiled = new Cascade();
+    compiled->backend = backend;
+    compiled->stages = (bandPassEnabled ? 1u : 0u) | (bandStopEnabled ? 2u : 0u) |
+                       (highPassEnabled ? 4u : 0u) | (lowPassEnabled ? 8u : 0u);
+    
+    if (backend == Backend::IIR) {
+        // Every filter's sections, one after another
+        std::vector<BiquadCascade::Section> sections;
+        const std::pair<bool, const std::vector<BiquadCascade::Section>*> stages[] = {
+            {bandPassEnabled, &bandPassSections},
+            {bandStopEnabled, &bandStopSections},
+            {highPassEnabled, &highPassSections},
+            {lowPassEnabled, &lowPassSections},
+        };
+        for (const auto& stage : stages) {
+            if (stage.first) {
+                sections.insert(sections.end(), stage.second->begin(), stage.second->end());
+            }
+        }
+        compiled->iir.setSections(sections);
+    } else {
+        // The filters are all linear and time-invariant, so running them in
+        // series is the same as running the convolution of their kernels
+        std::vector<const std::vector<float>*> kernels;
+        const std::pair<bool, const std::vector<float>*> stages[] = {
+            {bandPassEnabled, &bandPassCoeffs},
+            {bandStopEnabled, &bandStopCoeffs},
+            {highPassEnabled, &highPassCoeffs},
+            {lowPassEnabled, &lowPassCoeffs},
+        };
+        for (const auto& stage : stages) {
+            if (stage.first && !stage.second->empty()) {
+                kernels.push_back(stage.second);
+            }
+        }
+        compiled->fir.setCoefficients(composeKernels(kernels));
     }
     
-    if (bandStopEnabled && !bandStopCoeffs.empty()) {
-        output = applyFIR(bandStopCoeffs, bandStopDelayLine, output);
+    // Fully built here, so the audio side only has to swap it in
+    compiled->setChannelCount(channelCount);
+    publishCascade(compiled);
+}
+
+void FrequencyFilter::Cascade::setChannelCount(unsigned int channels) {
+    fir.setChannelCount(channels);
+    iir.setChannelCount(channels);
+}
+
+void FrequencyFilter::Cascade::process(const float* in, float* out, size_t count, unsigned int channel) {
+    if (backend == Backend::IIR) {
+        iir.process(in, out, count, channel);
+    } else {
+        fir.process(in, out, count, channel);
+    }
+}
+
+void FrequencyFilter::Cascade::processChannels(float* const* data, unsigned int channels, size_t count) {
+    if (backend == Backend::IIR) {
+        iir.processChannels(data, channels, count);
+    } else {
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            fir.process(data[ch], data[ch], count, ch);
+        }
+    }
+}
+
+void FrequencyFilter::Cascade::reset() {
+    fir.reset();
+    iir.reset();
+}
+
+size_t FrequencyFilter::Cascade::delaySamples() const {
+    if (backend == Backend::IIR || fir.empty()) {
+        return 0;
+    }
+    return (size_t)fir.getLatency() + (fir.getTaps() - 1) / 2;
+}
+
+bool FrequencyFilter::Cascade::copyStateFrom(const Cascade& other) {
+    if (other.backend != backend) {
+        return false;
+    }
+    if (backend == Backend::IIR) {
+        // Biquad state belongs to its section's poles; only worth keeping
+        // when the same filters were merely retuned
+        return other.stages == stages && iir.copyStateFrom(other.iir);
+    }
+    return fir.copyStateFrom(other.fir);
+}
+
+size_t FrequencyFilter::Cascade::settleSamples(bool primed) const {
+    if (backend == Backend::IIR) {
+        return primed ? 0 : IIR_SETTLE_SAMPLES;
+    }
+    // A primed direct form is exact from the first sample; overlap-save
+    // still hands out a block filtered with the old kernel, and an unprimed
+    // FIR needs its history filled
+    size_t settle = (size_t)fir.getLatency();
+    if (!primed && fir.getTaps() > 0) {
+        settle += fir.getTaps() - 1;
+    }
+    return settle;
+}
+
+std::vector<float> FrequencyFilter::composeKernels(const std::vector<const std::vector<float>*>& kernels) {
+    if (kernels.empty()) {
+        return std::vector<float>();
+    }
+    if (kernels.size() == 1) {
+        return *kernels[0];
     }
     
-    if (highPassEnabled && !highPassCoeffs.empty()) {
-        output = applyFIR(highPassCoeffs, highPassDelayLine, output);
+    size_t length = 1;
+    for (const std::vector<float>* kernel : kernels) {
+        length += kernel->size() - 1;
     }
     
-    if (lowPassEnabled && !lowPassCoeffs.empty()) {
-        output = applyFIR(lowPassCoeffs, lowPassDelayLine, output);
+    // Short results: convolve directly, one kernel at a time
+    if (length <= MAX_DIRECT_COMPOSE_TAPS) {
+        std::vector<float> result = *kernels[0];
+        for (size_t k = 1; k < kernels.size(); k++) {
+            const std::vector<float>& kernel = *kernels[k];
+            std::vector<float> next(result.size() + kernel.size() - 1, 0.0f);
+            for (size_t i = 0; i < result.size(); i++) {
+                for (size_t j = 0; j < kernel.size(); j++) {
+                    next[i + j] += result[i] * kernel[j];
+                }
+            }
+            result.swap(next);
+        }
+        return result;
     }
     
-    // Clamp output to prevent clipping and distortion
-    // Audio samples should be in range [-1.0, 1.0]
-    if (output > 1.0f) output = 1.0f;
-    if (output < -1.0f) output = -1.0f;
+    // Long results: multiply the spectra, zero-padded to a power of two at
+    // least as long as the result so the product is a linear convolution
+    int fftSize = 2;
+    while ((size_t)fftSize < length) {
+        fftSize *= 2;
+    }
+    const int bins = fftSize / 2 + 1;
+    const FFTPlanCache::Plans& plans = FFTPlanCache::get(fftSize);
+    float* time = fftwf_alloc_real(fftSize);
+    fftwf_complex* spectrum = fftwf_alloc_complex(bins);
+    std::vector<double> product(2 * bins, 0.0);
+    
+    for (size_t k = 0; k < kernels.size(); k++) {
+        const std::vector<float>& kernel = *kernels[k];
+        std::fill(time, time + fftSize, 0.0f);
+        std::copy(kernel.begin(), kernel.end(), time);
+        fftwf_execute_dft_r2c(plans.forward.load(std::memory_order_acquire), time, spectrum);
+        for (int b = 0; b < bins; b++) {
+            if (k == 0) {
+                product[2 * b] = spectrum[b][0];
+                product[2 * b + 1] = spectrum[b][1];
+            } else {
+                double re = product[2 * b];
+                double im = product[2 * b + 1];
+                product[2 * b] = re * spectrum[b][0] - im * spectrum[b][1];
+                product[2 * b + 1] = re * spectrum[b][1] + im * spectrum[b][0];
+            }
+        }
+    }
+    for (int b = 0; b < bins; b++) {
+        spectrum[b][0] = (float)(product[2 * b] / fftSize);
+        spectrum[b][1] = (float)(product[2 * b + 1] / fftSize);
+    }
+    fftwf_execute_dft_c2r(plans.inverse.load(std::memory_order_acquire), spectrum, time);
+    std::vector<float> result(time, time + length);
     
-    return output;
+    fftwf_free(time);
+    fftwf_free(spectrum);
+    return result;
 }
 
 void FrequencyFilter::processFFT(std::vector<float>& magnitudes, float sampleRate) {
@@ -95,39 +491,42 @@ void FrequencyFilter::processFFT(std::vector<float>& magnitudes, float sampleRat
     int fftSize = (magnitudes.size() - 1) * 2; // Reconstruct FFT size
     
     for (size_t i = 0; i < magnitudes.size(); i++) {
-        float freqHz = binToHz(i, fftSize, sampleRate);
-        
-        // Apply band-pass filter (keep only frequencies in range)
-        if (bandPassEnabled) {
-            if (freqHz < bandPassLow || freqHz > bandPassHigh) {
-                magnitudes[i] = 0.0f;
-                continue;
-            }
-        }
-        
-        // Apply band-stop filter (cut frequencies in range)
-        if (bandStopEnabled) {
-            if (freqHz >= bandStopLow && freqHz <= bandStopHigh) {
-                magnitudes[i] = 0.0f;
-                continue;
-            }
-        }
-        
-        // Apply high-pass filter (cut below cutoff)
-        if (highPassEnabled && freqHz < highPassCutoff) {
+        if (removesFrequency(binToHz(i, fftSize, sampleRate))) {
             magnitudes[i] = 0.0f;
-            continue;
         }
-        
-        // Apply low-pass filter (cut above cutoff)
-        if (lowPassEnabled && freqHz > lowPassCutoff) {
+    }
+}
+
+void FrequencyFilter::processBands(std::vector<float>& magnitudes, const std::vector<float>& frequencies) {
+    size_t count = std::min(magnitudes.size(), frequencies.size());
+    for (size_t i = 0; i < count; i++) {
+        if (removesFrequency(frequencies[i])) {
             magnitudes[i] = 0.0f;
-            continue;
         }
     }
 }
 
-void FrequencyFilter::processComplexFFT(fftw_complex* fftData, int fftSize, float sampleRate) {
+bool FrequencyFilter::removesFrequency(float freqHz) const {
+    // Apply band-pass filter (keep only frequencies in range)
+    if (bandPassEnabled && (freqHz < bandPassLow || freqHz > bandPassHigh)) {
+        return true;
+    }
+    
+    // Apply band-stop filter (cut frequencies in range)
+    if (bandStopEnabled && freqHz >= bandStopLow && freqHz <= bandStopHigh) {
+        return true;
+    }
+    
+    // Apply high-pass filter (cut below cutoff)
+    if (highPassEnabled && freqHz < highPassCutoff) {
+        return true;
+    }
+    
+    // Apply low-pass filter (cut above cutoff)
+    return lowPassEnabled && freqHz > lowPassCutoff;
+}
+
+void FrequencyFilter::processComplexFFT(fftwf_complex* fftData, int fftSize, float sampleRate) {
     if (!fftData || fftSize <= 0) return;
     
     int numBins = fftSize / 2 + 1;
@@ -169,10 +568,8 @@ void FrequencyFilter::processComplexFFT(fftw_complex* fftData, int fftSize, floa
 }
 
 void FrequencyFilter::reset() {
-    std::fill(lowPassDelayLine.begin(), lowPassDelayLine.end(), 0.0f);
-    std::fill(highPassDelayLine.begin(), highPassDelayLine.end(), 0.0f);
-    std::fill(bandStopDelayLine.begin(), bandStopDelayLine.end(), 0.0f);
-    std::fill(bandPassDelayLine.begin(), bandPassDelayLine.end(), 0.0f);
+    adoptLatest();
+    cascade->reset();
 }
 
 bool FrequencyFilter::isActive() const {
@@ -206,9 +603,6 @@ void FrequencyFilter::generateLowPassCoeffs(float cutoffHz, float sampleRate, in
             coeff /= sum;
         }
     }
-    
-    // Resize delay line to match
-    lowPassDelayLine.resize(filterLength, 0.0f);
 }
 
 void FrequencyFilter::generateHighPassCoeffs(float cutoffHz, float sampleRate, int filterLength) {
@@ -268,9 +662,6 @@ void FrequencyFilter::generateHighPassCoeffs(float cutoffHz, float sampleRate, i
             coeff /= absSum;
         }
     }
-    
-    // Resize delay line to match
-    highPassDelayLine.resize(filterLength, 0.0f);
 }
 
 void FrequencyFilter::generateBandStopCoeffs(float lowHz, float highHz, float sampleRate, int filterLength) {
@@ -305,9 +696,6 @@ void FrequencyFilter::generateBandStopCoeffs(float lowHz, float highHz, float sa
             coeff /= sum;
         }
     }
-    
-    // Resize delay line to match
-    bandStopDelayLine.resize(filterLength, 0.0f);
 }
 
 void FrequencyFilter::generateBandPassCoeffs(float lowHz, float highHz, float sampleRate, int filterLength) {
@@ -341,9 +729,6 @@ void FrequencyFilter::generateBandPassCoeffs(float lowHz, float highHz, float sa
             coeff /= sum;
         }
     }
-    
-    // Resize delay line to match
-    bandPassDelayLine.resize(filterLength, 0.0f);
 }
 
 float FrequencyFilter::blackmanWindow(int n, int N) {
@@ -362,31 +747,6 @@ float FrequencyFilter::sinc(float x) {
     return std::sin(pi * x) / (pi * x);
 }
 
-float FrequencyFilter::applyFIR(const std::vector<float>& coeffs, std::vector<float>& delayLine, float sample) {
-    if (coeffs.empty() || delayLine.size() != coeffs.size()) {
-        return sample;
-    }
-    
-    // Shift delay line
-    for (size_t i = delayLine.size() - 1; i > 0; i--) {
-        delayLine[i] = delayLine[i - 1];
-    }
-    delayLine[0] = sample;
-    
-    // Compute output
-    float output = 0.0f;
-    for (size_t i = 0; i < coeffs.size(); i++) {
-        output += coeffs[i] * delayLine[i];
-    }
-    
-    // Safety check: prevent NaN/Inf
-    if (!std::isfinite(output)) {
-        output = 0.0f;
-    }
-    
-    return output;
-}
-
 float FrequencyFilter::binToHz(int bin, int fftSize, float sampleRate) {
     return (bin * sampleRate) / fftSize;
 }
@@ -4,74 +4,228 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
 #include <fftw3.h>
+#include "FirFilter.h"
+#include "BiquadCascade.h"
 
+// Filter settings and designs live on the control side: the setters
+// recompute coefficients there and publish the result as a new, fully
+// built cascade through an atomic pointer. The audio side (processSample,
+// processBlock, processChannels) never blocks or allocates: it picks the
+// latest cascade up at the start of a block and fades over to it, so
+// retuning during playback does not click.
 class FrequencyFilter {
 public:
+    // Taps of the generated FIRs; long enough for steep transitions, which
+    // FirFilter runs by fast convolution
+    static constexpr int DEFAULT_FILTER_LENGTH = 2049;
+    
+    // Orders of the IIR designs: low/high-pass, and the band filters'
+    // prototypes (each a cascade of IIR_ORDER / 2 resp. IIR_BAND_ORDER biquads)
+    static constexpr int IIR_ORDER = 8;
+    static constexpr int IIR_BAND_ORDER = 4;
+    
+    // How the audio is filtered
+    enum class Backend {
+        FIR, // Linear phase, windowed-sinc FIRs (FirFilter)
+        IIR  // Minimum phase biquad cascade: far cheaper, no added latency
+    };
+    
+    // Samples over which the output moves from one cascade to the next: a
+    // crossfade when both delay the signal equally, otherwise a fade out
+    // of the old one followed by a fade in of the new one (mixing copies
+    // of the signal offset in time would comb-filter or echo)
+    static constexpr int CROSSFADE_SAMPLES = 512;
+    
+    // Samples an IIR cascade runs before being faded in when it cannot take
+    // over the previous one's state
+    static constexpr int IIR_SETTLE_SAMPLES = 2048;
+    
     FrequencyFilter();
     ~FrequencyFilter();
     
-    // Filter configuration
+    // Copies the settings and designs, with fresh filter state
+    FrequencyFilter(const FrequencyFilter& other);
+    FrequencyFilter& operator=(const FrequencyFilter&) = delete;
+    
+    // Filter configuration (control side; calls must not overlap). Changes
+    // reach the audio side with the next block.
     void setLowPassCutoff(float cutoffHz, float sampleRate);
     void setHighPassCutoff(float cutoffHz, float sampleRate);
     void setBandStop(float lowHz, float highHz, float sampleRate);
     void setBandPass(float lowHz, float highHz, float sampleRate);
     
     // Enable/disable filters
-    void enableLowPass(bool enabled) { lowPassEnabled = enabled; }
-    void enableHighPass(bool enabled) { highPassEnabled = enabled; }
-    void enableBandStop(bool enabled) { bandStopEnabled = enabled; }
-    void enableBandPass(bool enabled) { bandPassEnabled = enabled; }
+    void enableLowPass(bool enabled);
+    void enableHighPass(bool enabled);
+    void enableBandStop(bool enabled);
+    void enableBandPass(bool enabled);
     
-    // Apply filter to a single sample (time-domain filtering)
-    float processSample(float sample);
+    // Select the backend (and the IIR response); the settings carry over
+    void setBackend(Backend backend,
+                    BiquadCascade::Response response = BiquadCascade::Response::Butterworth);
+    Backend getBackend() const { return backend; }
+    BiquadCascade::Response getIirResponse() const { return iirResponse; }
     
-    // Apply filter to FFT magnitudes (frequency-domain filtering)
+    // Number of independent audio channels (each keeps its own filter
+    // history). Only while nothing is being processed.
+    void setChannelCount(unsigned int channels);
+    unsigned int getChannelCount() const { return channelCount; }
+    
+    // Apply filter to a single sample of one channel (time-domain filtering).
+    // During a crossfade every channel must be processed for it to finish.
+    float processSample(float sample, unsigned int channel = 0);
+    
+    // Apply filter to count samples of one channel; in and out may be the
+    // same buffer. Much cheaper per sample than processSample.
+    void processBlock(const float* in, float* out, size_t count, unsigned int channel = 0);
+    
+    // Filter count samples of each of channels planar channels in place
+    // (the IIR backend runs several channels per vector)
+    void processChannels(float* const* data, unsigned int channels, size_t count);
+    
+    // Apply filter to FFT magnitudes (frequency-domain filtering). Reads
+    // the settings lock-free, so any thread may call it.
     void processFFT(std::vector<float>& magnitudes, float sampleRate);
     
+    // Same for a spectrum with arbitrary bin frequencies (e.g. constant-Q)
+    void processBands(std::vector<float>& magnitudes, const std::vector<float>& frequencies);
+    
     // Apply filter to complex FFT data (zeros out filtered bins completely)
-    void processComplexFFT(fftw_complex* fftData, int fftSize, float sampleRate);
+    void processComplexFFT(fftwf_complex* fftData, int fftSize, float sampleRate);
+    
+    // Samples the output currently lags the input by: the engine's latency
+    // (overlap-save's block) plus the linear-phase FIRs' group delay; 0 for
+    // the IIR backend. Follows the cascade being played, so any thread may
+    // call it (e.g. to line the visuals up with what is heard).
+    size_t getDelay() const { return outputDelay.load(std::memory_order_relaxed); }
     
-    // Reset filter state
+    // Reset filter state, switching to the latest cascade at once. Only
+    // while nothing is being processed.
     void reset();
     
     // Check if any filter is active
     bool isActive() const;
 
 private:
-    // Filter types
-    bool lowPassEnabled;
-    bool highPassEnabled;
-    bool bandStopEnabled;
-    bool bandPassEnabled;
+    // Filter types (atomic: also read by the spectrum views on other threads)
+    std::atomic<bool> lowPassEnabled;
+    std::atomic<bool> highPassEnabled;
+    std::atomic<bool> bandStopEnabled;
+    std::atomic<bool> bandPassEnabled;
     
     // Filter parameters
-    float lowPassCutoff;
-    float highPassCutoff;
-    float bandStopLow;
-    float bandStopHigh;
-    float bandPassLow;
-    float bandPassHigh;
+    std::atomic<float> lowPassCutoff;
+    std::atomic<float> highPassCutoff;
+    std::atomic<float> bandStopLow;
+    std::atomic<float> bandStopHigh;
+    std::atomic<float> bandPassLow;
+    std::atomic<float> bandPassHigh;
     float currentSampleRate;
+    unsigned int channelCount;
+    Backend backend;
+    BiquadCascade::Response iirResponse;
     
-    // FIR filter coefficients and state
+    // FIR filter coefficients, one set per filter type
     std::vector<float> lowPassCoeffs;
     std::vector<float> highPassCoeffs;
     std::vector<float> bandStopCoeffs;
     std::vector<float> bandPassCoeffs;
     
-    // Filter delay lines (for FIR filtering)
-    std::vector<float> lowPassDelayLine;
-    std::vector<float> highPassDelayLine;
-    std::vector<float> bandStopDelayLine;
-    std::vector<float> bandPassDelayLine;
+    // Biquad designs of the same filters, for the IIR backend
+    std::vector<BiquadCascade::Section> lowPassSections;
+    std::vector<BiquadCascade::Section> highPassSections;
+    std::vector<BiquadCascade::Section> bandStopSections;
+    std::vector<BiquadCascade::Section> bandPassSections;
+    
+    // The enabled filters of one backend, with the per-channel state;
+    // compiled anew whenever a filter is enabled, disabled or retuned.
+    // FIR: their kernels convolved into one. IIR: their sections chained.
+    struct Cascade {
+        Backend backend = Backend::FIR;
+        unsigned int stages = 0; // Bit per enabled filter type
+        FirFilter fir;
+        BiquadCascade iir;
+        Cascade* nextRetired = nullptr;
+        
+        void setChannelCount(unsigned int channels);
+        void process(const float* in, float* out, size_t count, unsigned int channel);
+        void processChannels(float* const* data, unsigned int channels, size_t count);
+        void reset();
+        
+        // Start from other's state where it carries over (see FirFilter and
+        // BiquadCascade::copyStateFrom; IIR only for the same filter types)
+        bool copyStateFrom(const Cascade& other);
+        
+        // Samples to run before fading in, so the output no longer depends
+        // on state from before the switch
+        size_t settleSamples(bool primed) const;
+        
+        // Samples the audio comes out delayed by: engine latency plus the
+        // linear-phase FIR's group delay (IIRs count as 0)
+        size_t delaySamples() const;
+    };
+    
+    // Audio side: the cascade being played, the one being faded in (null
+    // outside a transition) and each channel's samples since it arrived.
+    // The incoming cascade starts fading in at transitionFadeIn; with
+    // transitionCrossfade unset the old one has faded out by then.
+    Cascade* cascade;
+    Cascade* incoming;
+    std::vector<size_t> transitionPos;
+    size_t transitionFadeIn;
+    bool transitionCrossfade;
+    std::atomic<size_t> outputDelay; // cascade->delaySamples(), for getDelay()
+    
+    // Audio side scratch: a crossfade runs in chunks of TRANSITION_CHUNK
+    static constexpr size_t TRANSITION_CHUNK = 1024;
+    std::vector<float> transitionInput;
+    std::vector<float> transitionOutput;
+    
+    // Handover: the latest compiled cascade not yet picked up, and a stack
+    // (linked through nextRetired) of replaced ones for the control side to
+    // delete
+    std::atomic<Cascade*> pendingCascade;
+    std::atomic<Cascade*> retiredCascades;
+    
+    // Composite kernels up to this length are convolved directly, longer
+    // ones by multiplying spectra
+    static constexpr size_t MAX_DIRECT_COMPOSE_TAPS = 1024;
     
     // Helper methods
     // Sharper FIR filters (longer length for stronger attenuation)
-    void generateLowPassCoeffs(float cutoffHz, float sampleRate, int filterLength = 257);
-    void generateHighPassCoeffs(float cutoffHz, float sampleRate, int filterLength = 257);
-    void generateBandStopCoeffs(float lowHz, float highHz, float sampleRate, int filterLength = 257);
-    void generateBandPassCoeffs(float lowHz, float highHz, float sampleRate, int filterLength = 257);
+    void generateLowPassCoeffs(float cutoffHz, float sampleRate, int filterLength = DEFAULT_FILTER_LENGTH);
+    void generateHighPassCoeffs(float cutoffHz, float sampleRate, int filterLength = DEFAULT_FILTER_LENGTH);
+    void generateBandStopCoeffs(float lowHz, float highHz, float sampleRate, int filterLength = DEFAULT_FILTER_LENGTH);
+    void generateBandPassCoeffs(float lowHz, float highHz, float sampleRate, int filterLength = DEFAULT_FILTER_LENGTH);
+    
+    // Redesign the biquads of every filter with valid settings
+    void designSections();
+    
+    // Build a cascade of the current backend from the enabled filters and
+    // publish it
+    void compileCascade();
+    
+    // Control side: hand a compiled cascade to the audio side, and delete
+    // the ones it has finished with
+    void publishCascade(Cascade* compiled);
+    void deleteRetired();
+    
+    // Control side, nothing processing: make the latest cascade current now
+    void adoptLatest();
+    
+    // Audio side: start a crossfade to a published cascade; filter one
+    // channel during one; end it once every channel is through
+    void pickUpCascade();
+    void processTransition(const float* in, float* out, size_t count, unsigned int channel);
+    void finishTransition();
+    
+    // Clamp to [-1, 1]
+    static void clampSamples(float* samples, size_t count);
+    
+    // Convolution of kernels (empty for none)
+    static std::vector<float> composeKernels(const std::vector<const std::vector<float>*>& kernels);
     
     // Window function (Blackman window)
     float blackmanWindow(int n, int N);
@@ -79,8 +233,8 @@ private:
     // Sinc function
     float sinc(float x);
     
-    // Apply FIR filter
-    float applyFIR(const std::vector<float>& coeffs, std::vector<float>& delayLine, float sample);
+    // Whether the enabled filters remove a frequency (for the spectrum views)
+    bool removesFrequency(float freqHz) const;
     
     // Convert frequency bin to Hz
     float binToHz(int bin, int fftSize, float sampleRate);
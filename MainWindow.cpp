@@ -15,7 +15,7 @@
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), audioPlayer(nullptr),
       maxMagnitude(0.0f), maxMagnitudeInitialized(false),
-      isDragging(false), dragStartBin(-1), dragEndBin(-1), activeDragView(nullptr) {
+      isDragging(false), dragStartBand(-1), dragEndBand(-1), activeDragView(nullptr) {
     setupUI();
     
     // Create audio player
@@ -24,13 +24,28 @@ MainWindow::MainWindow(QWidget* parent)
     // Connect signals
     connect(audioPlayer, &AudioPlayer::fftDataReady, this, &MainWindow::onFFTDataReady);
     connect(audioPlayer, &AudioPlayer::playbackFinished, this, &MainWindow::onPlaybackFinished);
+    connect(audioPlayer, &AudioPlayer::loadProgress, this, &MainWindow::onLoadProgress);
+    connect(audioPlayer, &AudioPlayer::loadFinished, this, &MainWindow::onLoadFinished);
     
     // Connect buttons
     connect(loadButton, &QPushButton::clicked, this, &MainWindow::onLoadFileClicked);
+    connect(cancelLoadButton, &QPushButton::clicked, this, &MainWindow::onCancelLoadClicked);
     connect(playButton, &QPushButton::clicked, this, &MainWindow::onPlayClicked);
     connect(pauseButton, &QPushButton::clicked, this, &MainWindow::onPauseClicked);
     connect(stopButton, &QPushButton::clicked, this, &MainWindow::onStopClicked);
     connect(exportButton, &QPushButton::clicked, this, &MainWindow::onExportClicked);
+    connect(positionSlider, &QSlider::sliderReleased, this, &MainWindow::onPositionSliderReleased);
+    connect(positionSlider, &QSlider::sliderMoved, this, &MainWindow::onPositionSliderMoved);
+    connect(fftSizeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFFTSizeChanged);
+    hopSizeCombo->setCurrentIndex(std::max(0, hopSizeCombo->findData(audioPlayer->getHopSize())));
+    windowCombo->setCurrentIndex(windowCombo->findData((int)audioPlayer->getAnalysisWindow()));
+    connect(hopSizeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onHopSizeChanged);
+    connect(windowCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onWindowChanged);
+    connect(bandScaleCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onBandScaleChanged);
     
     // Connect filter controls
     connect(lowPassSlider, &QSlider::valueChanged, this, &MainWindow::onLowPassSliderChanged);
@@ -40,6 +55,8 @@ MainWindow::MainWindow(QWidget* parent)
     connect(lowPassCheckbox, &QCheckBox::stateChanged, this, &MainWindow::onLowPassCheckboxChanged);
     connect(highPassCheckbox, &QCheckBox::stateChanged, this, &MainWindow::onHighPassCheckboxChanged);
     connect(bandStopCheckbox, &QCheckBox::stateChanged, this, &MainWindow::onBandStopCheckboxChanged);
+    connect(filterTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onFilterTypeChanged);
     
     // Install event filters for click-and-drag
     histogramView->installEventFilter(this);
@@ -52,6 +69,7 @@ MainWindow::MainWindow(QWidget* parent)
 
 MainWindow::~MainWindow() {
     if (audioPlayer) {
+        audioPlayer->cancelLoad();
         audioPlayer->stopPlayback();
     }
 }
@@ -71,20 +89,70 @@ void MainWindow::setupUI() {
     buttonLayout = new QHBoxLayout();
     
     loadButton = new QPushButton("Load File", this);
+    cancelLoadButton = new QPushButton("Cancel Load", this);
+    cancelLoadButton->setVisible(false);
     playButton = new QPushButton("Play", this);
     pauseButton = new QPushButton("Pause", this);
     stopButton = new QPushButton("Stop", this);
     exportButton = new QPushButton("Export Audio", this);
     
     buttonLayout->addWidget(loadButton);
+    buttonLayout->addWidget(cancelLoadButton);
     buttonLayout->addWidget(playButton);
     buttonLayout->addWidget(pauseButton);
     buttonLayout->addWidget(stopButton);
     buttonLayout->addWidget(exportButton);
+    
+    // Analysis FFT size: trades update rate for frequency resolution
+    fftSizeCombo = new QComboBox(this);
+    for (int size = FFTAnalyzer::MIN_FFT_SIZE; size <= FFTAnalyzer::MAX_FFT_SIZE; size *= 2) {
+        fftSizeCombo->addItem(QString::number(size), size);
+    }
+    fftSizeCombo->addItem("Multi (8192/2048/512)", MULTI_RESOLUTION_SIZE);
+    fftSizeCombo->setCurrentIndex(fftSizeCombo->findData(FFTAnalyzer::DEFAULT_FFT_SIZE));
+    buttonLayout->addWidget(new QLabel("FFT size:", this));
+    buttonLayout->addWidget(fftSizeCombo);
+    
+    // Overlap: a smaller hop gives smoother, lower-latency updates for more CPU
+    hopSizeCombo = new QComboBox(this);
+    hopSizeCombo->addItem("No overlap", 0);
+    for (int hop = 512; hop >= 64; hop /= 2) {
+        hopSizeCombo->addItem(QString::number(hop), hop);
+    }
+    buttonLayout->addWidget(new QLabel("Hop:", this));
+    buttonLayout->addWidget(hopSizeCombo);
+    
+    windowCombo = new QComboBox(this);
+    windowCombo->addItem("Rectangular", (int)FFTAnalyzer::WindowType::Rectangular);
+    windowCombo->addItem("Hann", (int)FFTAnalyzer::WindowType::Hann);
+    windowCombo->addItem("Blackman-Harris", (int)FFTAnalyzer::WindowType::BlackmanHarris);
+    buttonLayout->addWidget(new QLabel("Window:", this));
+    buttonLayout->addWidget(windowCombo);
+    
+    // Frequency scale of the charts: the spectrum is aggregated into bands
+    bandScaleCombo = new QComboBox(this);
+    bandScaleCombo->addItem("Log", (int)BandMapper::Scale::Log);
+    bandScaleCombo->addItem("1/3 octave", (int)BandMapper::Scale::ThirdOctave);
+    bandScaleCombo->addItem("Mel", (int)BandMapper::Scale::Mel);
+    bandScaleCombo->addItem("Constant-Q", CONSTANT_Q_BANDS);
+    buttonLayout->addWidget(new QLabel("Bands:", this));
+    buttonLayout->addWidget(bandScaleCombo);
     buttonLayout->addStretch();
     
+    // Decode progress, only shown while a file loads
+    loadProgressBar = new QProgressBar(this);
+    loadProgressBar->setRange(0, 100);
+    loadProgressBar->setVisible(false);
+    buttonLayout->addWidget(loadProgressBar);
+    
     mainLayout->addLayout(buttonLayout);
     
+    // Playback position (drag to seek)
+    positionSlider = new QSlider(Qt::Horizontal, this);
+    positionSlider->setRange(0, POSITION_SLIDER_STEPS);
+    positionSlider->setValue(0);
+    mainLayout->addWidget(positionSlider);
+    
     // Filter controls
     filterGroup = new QGroupBox("Frequency Filters", this);
     QGridLayout* filterLayout = new QGridLayout(filterGroup);
@@ -130,6 +198,14 @@ void MainWindow::setupUI() {
     filterLayout->addWidget(bandEndSlider, 2, 6);
     filterLayout->addWidget(bandEndLabel, 2, 7);
     
+    // Linear-phase FIRs, or minimum-phase biquads for lower cost and latency
+    filterTypeCombo = new QComboBox(this);
+    filterTypeCombo->addItem("Linear phase (FIR)", FILTER_TYPE_FIR);
+    filterTypeCombo->addItem("Butterworth (IIR)", FILTER_TYPE_BUTTERWORTH);
+    filterTypeCombo->addItem("Linkwitz-Riley (IIR)", FILTER_TYPE_LINKWITZ_RILEY);
+    filterLayout->addWidget(new QLabel("Filter type:", this), 3, 0);
+    filterLayout->addWidget(filterTypeCombo, 3, 1, 1, 2);
+    
     mainLayout->addWidget(filterGroup);
     
     // Tab widget for visualizations
@@ -143,18 +219,13 @@ void MainWindow::setupUI() {
     barSeries = new QBarSeries();
     barSet = new QBarSet("Magnitude");
     
-    QStringList categories;
-    for (int i = 0; i < MAX_BARS; i++) {
-        *barSet << 0.0;
-        categories << QString::number(i);
-    }
-    
+    // Bars and categories are added by resetBandAxes once a spectrum's
+    // bands are known
     barSeries->append(barSet);
     histogramChart->addSeries(barSeries);
     
     histogramAxisX = new QBarCategoryAxis();
-    histogramAxisX->append(categories);
-    histogramAxisX->setTitleText("Frequency Bin");
+    histogramAxisX->setTitleText("Band Center (Hz)");
     histogramChart->addAxis(histogramAxisX, Qt::AlignBottom);
     barSeries->attachAxis(histogramAxisX);
     
@@ -180,8 +251,8 @@ void MainWindow::setupUI() {
     linePlotChart->addSeries(lineSeries);
     
     linePlotAxisX = new QValueAxis();
-    linePlotAxisX->setTitleText("Frequency Bin");
-    linePlotAxisX->setRange(0, MAX_BARS);
+    linePlotAxisX->setTitleText("Band");
+    linePlotAxisX->setRange(0, DISPLAY_BANDS - 1);
     linePlotChart->addAxis(linePlotAxisX, Qt::AlignBottom);
     lineSeries->attachAxis(linePlotAxisX);
     
@@ -220,16 +291,49 @@ void MainWindow::onLoadFileClicked() {
         return;
     }
     
-    statusLabel->setText("Loading file...");
-    QApplication::processEvents(); // Update UI
+    // Large files are decoded in the background while they play
+    bool streaming = QFileInfo(filename).size() > STREAMING_THRESHOLD_BYTES;
     
-    if (audioPlayer->loadFile(filename.toStdString())) {
-        statusLabel->setText("File loaded: " + QFileInfo(filename).fileName());
+    // Decode on a worker thread; the window keeps repainting (and the current
+    // file keeps playing) until onLoadFinished
+    loadingFilename = filename;
+    statusLabel->setText("Loading " + QFileInfo(filename).fileName() + "...");
+    loadProgressBar->setValue(0);
+    loadProgressBar->setVisible(true);
+    cancelLoadButton->setVisible(true);
+    audioPlayer->loadFileAsync(filename.toStdString(), streaming);
+}
+
+void MainWindow::onCancelLoadClicked() {
+    audioPlayer->cancelLoad();
+    loadProgressBar->setVisible(false);
+    cancelLoadButton->setVisible(false);
+    statusLabel->setText("Loading cancelled");
+}
+
+void MainWindow::onLoadProgress(double decodedSeconds, double totalSeconds) {
+    if (!audioPlayer->isLoading() || totalSeconds <= 0.0) {
+        return; // Late progress from a cancelled load
+    }
+    loadProgressBar->setValue((int)(decodedSeconds / totalSeconds * 100.0));
+    statusLabel->setText(QString("Loading %1... %2 / %3 s")
+                         .arg(QFileInfo(loadingFilename).fileName())
+                         .arg(decodedSeconds, 0, 'f', 0)
+                         .arg(totalSeconds, 0, 'f', 0));
+}
+
+void MainWindow::onLoadFinished(bool success) {
+    loadProgressBar->setVisible(false);
+    cancelLoadButton->setVisible(false);
+    
+    if (success) {
+        statusLabel->setText("File loaded: " + QFileInfo(loadingFilename).fileName());
         setPlaybackControlsEnabled(true);
+        positionSlider->setValue(0);
     } else {
-        QMessageBox::critical(this, "Error", "Failed to load audio file: " + filename);
+        // The previously loaded file (if any) is still in place
+        QMessageBox::critical(this, "Error", "Failed to load audio file: " + loadingFilename);
         statusLabel->setText("Failed to load file");
-        setPlaybackControlsEnabled(false);
     }
 }
 
@@ -264,19 +368,17 @@ void MainWindow::onStopClicked() {
     playButton->setEnabled(true);
     pauseButton->setEnabled(false);
     stopButton->setEnabled(false);
+    positionSlider->setValue(0);
     
     // Reset charts
-    for (int i = 0; i < MAX_BARS; i++) {
+    for (int i = 0; i < barSet->count(); i++) {
         barSet->replace(i, 0.0);
     }
     lineSeries->clear();
     radialView->updateData(std::vector<float>());
     
     // Reset smoothing state
-    magnitudeHistory.clear();
-    previousSmoothed.clear();
-    maxMagnitude = 0.0f;
-    maxMagnitudeInitialized = false;
+    resetSmoothing();
 }
 
 void MainWindow::onExportClicked() {
@@ -316,8 +418,24 @@ void MainWindow::onExportClicked() {
 }
 
 void MainWindow::onFFTDataReady(const std::vector<float>& magnitudes) {
+    // Track playback position unless the user is dragging the slider
+    size_t total = audioPlayer->getTotalLength();
+    if (total > 0 && !positionSlider->isSliderDown()) {
+        positionSlider->setValue((int)((double)audioPlayer->getCurrentPosition() / total * POSITION_SLIDER_STEPS));
+    }
+    
+    // Aggregate the bins into display bands
+    if (!updateBandMapper(magnitudes.size())) {
+        return;
+    }
+    if (bandMapper.empty()) {
+        bandMagnitudes = magnitudes; // Constant-Q frames are bands already
+    } else if (!bandMapper.apply(magnitudes, bandMagnitudes)) {
+        return;
+    }
+    
     // Apply smoothing
-    std::vector<float> smoothed = smoothMagnitudes(magnitudes);
+    std::vector<float> smoothed = smoothMagnitudes(bandMagnitudes);
     
     // Update all visualizations
     updateChart(smoothed);
@@ -328,15 +446,149 @@ void MainWindow::onPlaybackFinished() {
     playButton->setEnabled(true);
     pauseButton->setEnabled(false);
     stopButton->setEnabled(false);
+    positionSlider->setValue(0);
     
     // Reset charts
-    for (int i = 0; i < MAX_BARS; i++) {
+    for (int i = 0; i < barSet->count(); i++) {
         barSet->replace(i, 0.0);
     }
     lineSeries->clear();
     radialView->updateData(std::vector<float>());
     
     // Reset smoothing state
+    resetSmoothing();
+}
+
+void MainWindow::onPositionSliderReleased() {
+    size_t total = audioPlayer->getTotalLength();
+    if (total == 0) {
+        return;
+    }
+    audioPlayer->seek((size_t)((double)positionSlider->value() / POSITION_SLIDER_STEPS * total));
+}
+
+void MainWindow::onPositionSliderMoved(int value) {
+    // Preview the spectrum under the handle; a table lookup once the
+    // spectrogram is ready, so it can follow the drag
+    size_t total = audioPlayer->getTotalLength();
+    if (total > 0) {
+        audioPlayer->showSpectrumAt((size_t)((double)value / POSITION_SLIDER_STEPS * total));
+    }
+}
+
+void MainWindow::onFFTSizeChanged(int index) {
+    if (!audioPlayer || index < 0) {
+        return;
+    }
+    int size = fftSizeCombo->itemData(index).toInt();
+    if (size != MULTI_RESOLUTION_SIZE) {
+        audioPlayer->setFFTSize(size);
+    }
+    applyAnalysisMode();
+    resetSmoothing();
+}
+
+void MainWindow::onHopSizeChanged(int index) {
+    if (!audioPlayer || index < 0) {
+        return;
+    }
+    audioPlayer->setHopSize(hopSizeCombo->itemData(index).toInt());
+}
+
+void MainWindow::onWindowChanged(int index) {
+    if (!audioPlayer || index < 0) {
+        return;
+    }
+    audioPlayer->setAnalysisWindow((FFTAnalyzer::WindowType)windowCombo->itemData(index).toInt());
+    resetSmoothing();
+}
+
+void MainWindow::onBandScaleChanged(int index) {
+    if (!audioPlayer || index < 0) {
+        return;
+    }
+    // The player switches analyzers; the layout is rebuilt when the first
+    // spectrum of the new kind arrives, or now if only the scale changed
+    applyAnalysisMode();
+    if (!isConstantQSelected() && !bandMapper.empty()) {
+        updateBandMapper(bandMapper.getInputBins());
+    }
+}
+
+bool MainWindow::isConstantQSelected() const {
+    return bandScaleCombo->currentData().toInt() == CONSTANT_Q_BANDS;
+}
+
+void MainWindow::applyAnalysisMode() {
+    // Constant-Q replaces the FFT entirely; otherwise the size picks the mode
+    AudioPlayer::AnalysisMode mode = AudioPlayer::AnalysisMode::FFT;
+    if (isConstantQSelected()) {
+        mode = AudioPlayer::AnalysisMode::ConstantQ;
+    } else if (fftSizeCombo->currentData().toInt() == MULTI_RESOLUTION_SIZE) {
+        mode = AudioPlayer::AnalysisMode::MultiResolution;
+    }
+    if (mode != audioPlayer->getAnalysisMode()) {
+        audioPlayer->setAnalysisMode(mode);
+    }
+}
+
+bool MainWindow::updateBandMapper(size_t bins) {
+    unsigned int sampleRate = audioPlayer->getSampleRate();
+    if (bins < 2 || sampleRate == 0) {
+        return false;
+    }
+    if (isConstantQSelected()) {
+        // FFT spectra still queued from before the switch are dropped
+        if (audioPlayer->getAnalysisMode() != AudioPlayer::AnalysisMode::ConstantQ || bins != (size_t)audioPlayer->getConstantQ().getBins()) {
+            return false;
+        }
+        if (!bandMapper.empty() || barSet->count() != (int)bins) {
+            bandMapper = BandMapper();
+            resetSmoothing();
+            resetBandAxes();
+        }
+        return true;
+    }
+    
+    BandMapper::Scale scale = (BandMapper::Scale)bandScaleCombo->currentData().toInt();
+    if (!bandMapper.empty() && bandMapper.getInputBins() == (int)bins &&
+        bandMapper.getSampleRate() == sampleRate && bandMapper.getScale() == scale) {
+        return true;
+    }
+    
+    bool ok = bandMapper.configure(scale, DISPLAY_BANDS, (int)(bins - 1) * 2, sampleRate);
+    resetSmoothing();
+    resetBandAxes();
+    return ok;
+}
+
+void MainWindow::resetBandAxes() {
+    const ConstantQAnalyzer& cq = audioPlayer->getConstantQ();
+    int bands = bandMapper.empty() ? cq.getBins() : bandMapper.getBands();
+    QStringList categories;
+    barSet->remove(0, barSet->count());
+    for (int i = 0; i < bands; i++) {
+        *barSet << 0.0;
+        float hz = bandMapper.empty() ? cq.getFrequency(i) : bandMapper.getCenterHz(i);
+        categories << (hz >= 1000.0f ? QString::number(hz / 1000.0f, 'f', 1) + "k"
+                                     : QString::number((int)std::lround(hz)));
+    }
+    histogramAxisX->clear();
+    histogramAxisX->append(categories);
+    linePlotAxisX->setRange(0, std::max(1, bands - 1));
+    lineSeries->clear();
+    radialView->updateData(std::vector<float>());
+}
+
+float MainWindow::bandLowHz(int band) const {
+    return bandMapper.empty() ? audioPlayer->getConstantQ().getLowHz(band) : bandMapper.getLowHz(band);
+}
+
+float MainWindow::bandHighHz(int band) const {
+    return bandMapper.empty() ? audioPlayer->getConstantQ().getHighHz(band) : bandMapper.getHighHz(band);
+}
+
+void MainWindow::resetSmoothing() {
     magnitudeHistory.clear();
     previousSmoothed.clear();
     maxMagnitude = 0.0f;
@@ -359,6 +611,11 @@ std::vector<float> MainWindow::smoothMagnitudes(const std::vector<float>& magnit
         return magnitudes;
     }
     
+    // Spectra queued before an FFT size change have a different bin count
+    if (!previousSmoothed.empty() && previousSmoothed.size() != magnitudes.size()) {
+        resetSmoothing();
+    }
+    
     std::vector<float> smoothed(magnitudes.size());
     
     // Apply EMA
@@ -399,7 +656,7 @@ void MainWindow::updateHistogram(const std::vector<float>& magnitudes) {
         return;
     }
     
-    int bars_to_show = std::min(MAX_BARS, (int)magnitudes.size());
+    int bars_to_show = std::min(barSet->count(), (int)magnitudes.size());
     float max_magnitude = 0.0f;
     
     for (int i = 0; i < bars_to_show; i++) {
@@ -430,9 +687,7 @@ void MainWindow::updateLinePlot(const std::vector<float>& magnitudes) {
     }
     
     lineSeries->clear();
-    int points_to_show = std::min(MAX_BARS, (int)magnitudes.size());
-    
-    for (int i = 0; i < points_to_show; i++) {
+    for (int i = 0; i < (int)magnitudes.size(); i++) {
         lineSeries->append(i, magnitudes[i]);
     }
     
@@ -461,6 +716,7 @@ void MainWindow::setPlaybackControlsEnabled(bool enabled) {
     pauseButton->setEnabled(false);
     stopButton->setEnabled(false);
     exportButton->setEnabled(enabled); // Enable export when file is loaded
+    positionSlider->setEnabled(enabled);
 }
 
 void MainWindow::onLowPassSliderChanged(int value) {
@@ -528,6 +784,23 @@ void MainWindow::onBandStopCheckboxChanged(int state) {
     }
 }
 
+void MainWindow::onFilterTypeChanged(int index) {
+    if (!audioPlayer || index < 0) {
+        return;
+    }
+    switch (filterTypeCombo->itemData(index).toInt()) {
+    case FILTER_TYPE_BUTTERWORTH:
+        audioPlayer->setFilterBackend(FrequencyFilter::Backend::IIR, BiquadCascade::Response::Butterworth);
+        break;
+    case FILTER_TYPE_LINKWITZ_RILEY:
+        audioPlayer->setFilterBackend(FrequencyFilter::Backend::IIR, BiquadCascade::Response::LinkwitzRiley);
+        break;
+    default:
+        audioPlayer->setFilterBackend(FrequencyFilter::Backend::FIR);
+        break;
+    }
+}
+
 bool MainWindow::eventFilter(QObject* obj, QEvent* event) {
     QChartView* view = qobject_cast<QChartView*>(obj);
     RadialVisualizationWidget* radialWidget = qobject_cast<RadialVisualizationWidget*>(obj);
@@ -563,31 +836,30 @@ void MainWindow::handleMousePress(QMouseEvent* event, QWidget* view) {
     if (event->button() == Qt::LeftButton) {
         isDragging = true;
         activeDragView = view;
-        dragStartBin = mouseXToFrequencyBin(event->x(), view, FFT_SIZE);
-        dragEndBin = dragStartBin;
+        dragStartBand = mouseXToBand(event->x(), view);
+        dragEndBand = dragStartBand;
     }
 }
 
 void MainWindow::handleMouseMove(QMouseEvent* event, QWidget* view) {
     if (isDragging && activeDragView == view) {
-        dragEndBin = mouseXToFrequencyBin(event->x(), view, FFT_SIZE);
+        dragEndBand = mouseXToBand(event->x(), view);
         // Visual feedback could be added here (highlight selected range)
     }
 }
 
 void MainWindow::handleMouseRelease(QMouseEvent* event, QWidget* view) {
     if (event->button() == Qt::LeftButton && isDragging && activeDragView == view) {
-        dragEndBin = mouseXToFrequencyBin(event->x(), view, FFT_SIZE);
+        dragEndBand = mouseXToBand(event->x(), view);
         
         // Apply band-stop filter to selected range
-        if (dragStartBin >= 0 && dragEndBin >= 0 && audioPlayer && audioPlayer->getSampleRate() > 0) {
-            int startBin = std::min(dragStartBin, dragEndBin);
-            int endBin = std::max(dragStartBin, dragEndBin);
+        if (dragStartBand >= 0 && dragEndBand >= 0 && audioPlayer && audioPlayer->getSampleRate() > 0) {
+            int startBand = std::min(dragStartBand, dragEndBand);
+            int endBand = std::max(dragStartBand, dragEndBand);
             
-            // Convert bins to Hz
-            float sampleRate = audioPlayer->getSampleRate();
-            float startHz = (startBin * sampleRate) / FFT_SIZE;
-            float endHz = (endBin * sampleRate) / FFT_SIZE;
+            // The selection spans the outer edges of the dragged bands
+            float startHz = bandLowHz(startBand);
+            float endHz = bandHighHz(endBand);
             
             // Update sliders and apply filter
             bandStartSlider->setValue((int)startHz);
@@ -602,21 +874,22 @@ void MainWindow::handleMouseRelease(QMouseEvent* event, QWidget* view) {
     }
 }
 
-int MainWindow::mouseXToFrequencyBin(int x, QWidget* view, int fftSize) {
+int MainWindow::mouseXToBand(int x, QWidget* view) {
     QChartView* chartView = qobject_cast<QChartView*>(view);
-    if (chartView) {
+    int bands = barSet->count();
+    if (chartView && bands > 0) {
         QPointF scenePos = chartView->mapToScene(x, 0);
         QPointF chartPos = chartView->chart()->mapFromScene(scenePos);
         
         // Get chart plot area
         QRectF plotArea = chartView->chart()->plotArea();
         
-        // Convert x coordinate to frequency bin
+        // Convert x coordinate to display band
         float normalizedX = (chartPos.x() - plotArea.left()) / plotArea.width();
-        int bin = (int)(normalizedX * MAX_BARS);
+        int band = (int)(normalizedX * bands);
         
-        return std::max(0, std::min(bin, MAX_BARS - 1));
+        return std::max(0, std::min(band, bands - 1));
     }
-    return 0;
+    return -1;
 }
 
@@ -8,6 +8,7 @@
 #include <QWidget>
 #include <QFileDialog>
 #include <QLabel>
+#include <QProgressBar>
 #include <QtCharts/QChartView>
 #include <QtCharts/QBarSeries>
 #include <QtCharts/QBarSet>
@@ -17,6 +18,7 @@
 #include <QtCharts/QLineSeries>
 #include <QTabWidget>
 #include <QSlider>
+#include <QComboBox>
 #include <QCheckBox>
 #include <QGroupBox>
 #include <QDoubleSpinBox>
@@ -25,6 +27,7 @@
 #include <deque>
 #include "AudioPlayer.h"
 #include "FFTAnalyzer.h"
+#include "BandMapper.h"
 #include "RadialVisualizationWidget.h"
 
 class MainWindow : public QMainWindow {
@@ -36,18 +39,39 @@ public:
 
 private slots:
     void onLoadFileClicked();
+    void onCancelLoadClicked();
+    void onLoadProgress(double decodedSeconds, double totalSeconds);
+    void onLoadFinished(bool success);
     void onPlayClicked();
     void onPauseClicked();
     void onStopClicked();
     void onExportClicked();
     void onFFTDataReady(const std::vector<float>& magnitudes);
     void onPlaybackFinished();
+    void onPositionSliderReleased();
+    void onPositionSliderMoved(int value);
+    void onFFTSizeChanged(int index);
+    void onHopSizeChanged(int index);
+    void onWindowChanged(int index);
+    void onBandScaleChanged(int index);
 
 private:
     void setupUI();
     void updateChart(const std::vector<float>& magnitudes);
     void setPlaybackControlsEnabled(bool enabled);
     std::vector<float> smoothMagnitudes(const std::vector<float>& magnitudes);
+    void resetSmoothing();
+    
+    // Rebuild bandMapper for spectra of bins bins (if the size, sample rate
+    // or scale changed) and relabel the chart axes; false if the spectrum
+    // cannot be shown. With Constant-Q selected the frames are already
+    // bands and bandMapper stays empty.
+    bool updateBandMapper(size_t bins);
+    void resetBandAxes();
+    bool isConstantQSelected() const;
+    void applyAnalysisMode();
+    float bandLowHz(int band) const;
+    float bandHighHz(int band) const;
     
     // Visualization update methods
     void updateHistogram(const std::vector<float>& magnitudes);
@@ -62,24 +86,32 @@ private:
     void onLowPassCheckboxChanged(int state);
     void onHighPassCheckboxChanged(int state);
     void onBandStopCheckboxChanged(int state);
+    void onFilterTypeChanged(int index);
     
     // Mouse event handlers for click-and-drag
     bool eventFilter(QObject* obj, QEvent* event) override;
     void handleMousePress(QMouseEvent* event, QWidget* view);
     void handleMouseMove(QMouseEvent* event, QWidget* view);
     void handleMouseRelease(QMouseEvent* event, QWidget* view);
-    int mouseXToFrequencyBin(int x, QWidget* view, int fftSize);
+    int mouseXToBand(int x, QWidget* view);
     
     // UI Components
     QWidget* centralWidget;
     QVBoxLayout* mainLayout;
     QHBoxLayout* buttonLayout;
     QPushButton* loadButton;
+    QPushButton* cancelLoadButton;
     QPushButton* playButton;
     QPushButton* pauseButton;
     QPushButton* stopButton;
     QPushButton* exportButton;
     QLabel* statusLabel;
+    QProgressBar* loadProgressBar;
+    QSlider* positionSlider;
+    QComboBox* fftSizeCombo;
+    QComboBox* hopSizeCombo;
+    QComboBox* windowCombo;
+    QComboBox* bandScaleCombo;
     
     // Tab widget for visualizations
     QTabWidget* tabWidget;
@@ -111,6 +143,7 @@ private:
     QCheckBox* lowPassCheckbox;
     QCheckBox* highPassCheckbox;
     QCheckBox* bandStopCheckbox;
+    QComboBox* filterTypeCombo;
     QLabel* lowPassLabel;
     QLabel* highPassLabel;
     QLabel* bandStartLabel;
@@ -118,6 +151,11 @@ private:
     
     // Audio player
     AudioPlayer* audioPlayer;
+    QString loadingFilename; // File being loaded in the background
+    
+    // Display bands: each chart point is a band of the spectrum
+    BandMapper bandMapper;
+    std::vector<float> bandMagnitudes;
     
     // Smoothing and stabilization
     std::deque<std::vector<float>> magnitudeHistory; // For SMA
@@ -129,13 +167,24 @@ private:
     
     // Click-and-drag state
     bool isDragging;
-    int dragStartBin;
-    int dragEndBin;
+    int dragStartBand;
+    int dragEndBand;
     QWidget* activeDragView;
     
-    // Chart data
-    static constexpr int MAX_BARS = 64; // Display first 64 bars for better performance
-    // FFT_SIZE is defined in FFTAnalyzer.h as a macro
+    static constexpr int POSITION_SLIDER_STEPS = 1000;
+    
+    // Files larger than this are streamed instead of decoded up front
+    static constexpr qint64 STREAMING_THRESHOLD_BYTES = 16 * 1024 * 1024;
+    
+    // Band count for the mel and log scales (1/3 octave is fixed by the range)
+    static constexpr int DISPLAY_BANDS = 64;
+    static constexpr int CONSTANT_Q_BANDS = -1; // bandScaleCombo data for Constant-Q
+    static constexpr int MULTI_RESOLUTION_SIZE = 0; // fftSizeCombo data for Multi
+    
+    // filterTypeCombo data
+    static constexpr int FILTER_TYPE_FIR = 0;
+    static constexpr int FILTER_TYPE_BUTTERWORTH = 1;
+    static constexpr int FILTER_TYPE_LINKWITZ_RILEY = 2;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,99 @@
+#include "Mp3FrameIndex.h"
+#include <mad.h>
+#include <algorithm>
+
+Mp3FrameIndex::Mp3FrameIndex()
+    : total_samples(0), samples_per_frame(0), sample_rate(0), channels(0) {
+}
+
+bool Mp3FrameIndex::build(const unsigned char* data, size_t size) {
+    clear();
+    if (!data || size == 0) {
+        return false;
+    }
+
+    struct mad_stream stream;
+    struct mad_header header;
+    mad_stream_init(&stream);
+    mad_header_init(&header);
+    mad_stream_buffer(&stream, data, size);
+
+    // mad_header_decode only parses the 4-byte header (plus CRC) and skips
+    // to the next frame, so this touches a few bytes per frame
+    while (1) {
+        if (mad_header_decode(&header, &stream)) {
+            if (MAD_RECOVERABLE(stream.error)) {
+                continue;
+            }
+            break;
+        }
+
+        if (frames.empty()) {
+            sample_rate = header.samplerate;
+            channels = MAD_NCHANNELS(&header);
+        }
+        addFrame(stream.this_frame - data, 32 * MAD_NSBSAMPLES(&header));
+    }
+
+    mad_header_finish(&header);
+    mad_stream_finish(&stream);
+    return !frames.empty();
+}
+
+void Mp3FrameIndex::addFrame(size_t byteOffset, unsigned int samples) {
+    if (frames.empty()) {
+        samples_per_frame = samples;
+    } else if (samples != samples_per_frame) {
+        samples_per_frame = 0;
+    }
+    frames.push_back({byteOffset, total_samples});
+    total_samples += samples;
+}
+
+void Mp3FrameIndex::clear() {
+    frames.clear();
+    total_samples = 0;
+    samples_per_frame = 0;
+    sample_rate = 0;
+    channels = 0;
+}
+
+size_t Mp3FrameIndex::frameForSample(size_t sample) const {
+    if (frames.empty()) {
+        return npos;
+    }
+    if (sample >= total_samples) {
+        return frames.size() - 1;
+    }
+    if (samples_per_frame > 0) {
+        return sample / samples_per_frame;
+    }
+
+    // Mixed frame sizes: last frame starting at or before the sample
+    auto it = std::upper_bound(frames.begin(), frames.end(), (uint64_t)sample,
+                               [](uint64_t value, const Entry& e) { return value < e.start_sample; });
+    return (it - frames.begin()) - 1;
+}
+
+size_t Mp3FrameIndex::frameAtOffset(size_t byteOffset) const {
+    auto it = std::lower_bound(frames.begin(), frames.end(), (uint64_t)byteOffset,
+                               [](const Entry& e, uint64_t value) { return e.offset < value; });
+    if (it == frames.end() || it->offset != byteOffset) {
+        return npos;
+    }
+    return it - frames.begin();
+}
+
+size_t Mp3FrameIndex::primingFrame(size_t frame) const {
+    size_t first = frame;
+    while (first > 0 && frames[frame].offset - frames[first].offset < MAX_RESERVOIR_BYTES) {
+        first--;
+    }
+    // One more frame so the synthesis overlap is filled as well
+    return first > 0 ? first - 1 : 0;
+}
+
+size_t Mp3FrameIndex::frameSamples(size_t frame) const {
+    size_t end = (frame + 1 < frames.size()) ? frames[frame + 1].start_sample : total_samples;
+    return end - frames[frame].start_sample;
+}
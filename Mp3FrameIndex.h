@@ -0,0 +1,62 @@
+#ifndef MP3FRAMEINDEX_H
+#define MP3FRAMEINDEX_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Maps sample positions to MPEG audio frame byte offsets so a decoder can
+// start anywhere in the file instead of decoding everything before it.
+class Mp3FrameIndex {
+public:
+    static constexpr size_t npos = (size_t)-1;
+
+    Mp3FrameIndex();
+
+    // Build the index with a header-only scan (no Huffman decode or synthesis)
+    bool build(const unsigned char* data, size_t size);
+
+    // Append a frame found while decoding; frames must be added in file order
+    void addFrame(size_t byteOffset, unsigned int samples);
+
+    void clear();
+
+    bool empty() const { return frames.empty(); }
+    size_t frameCount() const { return frames.size(); }
+    size_t totalSamples() const { return total_samples; }
+
+    // Stream parameters of the first frame (valid after build)
+    unsigned int getSampleRate() const { return sample_rate; }
+    unsigned int getChannels() const { return channels; }
+
+    // Frame containing the given sample (O(1) for constant frame sizes)
+    size_t frameForSample(size_t sample) const;
+
+    // Frame starting at the given byte offset, or npos if there is none
+    size_t frameAtOffset(size_t byteOffset) const;
+
+    // First frame to decode so that the given frame comes out fully primed
+    // (Layer III bit reservoir and IMDCT overlap); output before it is discarded
+    size_t primingFrame(size_t frame) const;
+
+    size_t frameOffset(size_t frame) const { return frames[frame].offset; }
+    size_t frameStartSample(size_t frame) const { return frames[frame].start_sample; }
+    size_t frameSamples(size_t frame) const;
+
+private:
+    struct Entry {
+        uint64_t offset;       // Byte offset of the frame header
+        uint64_t start_sample; // Position of the frame's first output sample
+    };
+
+    // Layer III main_data_begin can reach this many bytes back into earlier frames
+    static constexpr uint64_t MAX_RESERVOIR_BYTES = 511;
+
+    std::vector<Entry> frames;
+    size_t total_samples;
+    unsigned int samples_per_frame; // 0 if frame sizes vary
+    unsigned int sample_rate;
+    unsigned int channels;
+};
+
+#endif // MP3FRAMEINDEX_H
@@ -0,0 +1,186 @@
+#include "MultiResolutionAnalyzer.h"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+// Schedules longer than this many hops are not worth balancing exactly
+constexpr long MAX_SCHEDULE_HOPS = 1 << 12;
+
+} // namespace
+
+MultiResolutionAnalyzer::MultiResolutionAnalyzer()
+    : sample_rate(0), hop_size(0), window_type(FFTAnalyzer::WindowType::Rectangular),
+      ring_size(0), write_pos(0), filled(0), since_hop(0), hop_index(0) {
+}
+
+std::vector<MultiResolutionAnalyzer::Range> MultiResolutionAnalyzer::defaultLayout() {
+    return {{8192, 250.0f}, {2048, 2500.0f}, {512, 0.0f}};
+}
+
+bool MultiResolutionAnalyzer::configure(const std::vector<Range>& layout, unsigned int sampleRate) {
+    if (layout.empty() || sampleRate == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < layout.size(); i++) {
+        int size = layout[i].fft_size;
+        float previousHz = (i > 0) ? layout[i - 1].max_hz : 0.0f;
+        if (size < FFTAnalyzer::MIN_FFT_SIZE || size > FFTAnalyzer::MAX_FFT_SIZE ||
+            (i > 0 && size > layout[i - 1].fft_size) ||
+            (i + 1 < layout.size() && layout[i].max_hz <= previousHz)) {
+            std::cerr << "Invalid multi-resolution layout at range " << i << std::endl;
+            return false;
+        }
+    }
+
+    stages.clear();
+    sample_rate = sampleRate;
+    ring_size = layout[0].fft_size;
+    const int bins = ring_size / 2 + 1;
+    int first = 0;
+    for (size_t i = 0; i < layout.size(); i++) {
+        Stage stage;
+        stage.analyzer.reset(new FFTAnalyzer(layout[i].fft_size));
+        stage.analyzer->setWindow(window_type);
+        stage.first_bin = first;
+        stage.last_bin = (i + 1 == layout.size())
+            ? bins
+            : std::min(bins, (int)std::ceil(layout[i].max_hz * ring_size / sampleRate));
+        stage.scale = (float)ring_size / layout[i].fft_size;
+        stage.period = 1;
+        stage.phase = 0;
+        stage.cost = layout[i].fft_size * std::log2((double)layout[i].fft_size);
+        first = std::max(first, stage.last_bin);
+        stages.push_back(std::move(stage));
+    }
+
+    ring.assign(2 * ring_size, 0.0f);
+    magnitudes.assign(bins, 0.0f);
+    schedule();
+    reset();
+    return true;
+}
+
+void MultiResolutionAnalyzer::swap(MultiResolutionAnalyzer& other) {
+    stages.swap(other.stages);
+    std::swap(sample_rate, other.sample_rate);
+    std::swap(hop_size, other.hop_size);
+    std::swap(window_type, other.window_type);
+    ring.swap(other.ring);
+    std::swap(ring_size, other.ring_size);
+    std::swap(write_pos, other.write_pos);
+    std::swap(filled, other.filled);
+    std::swap(since_hop, other.since_hop);
+    std::swap(hop_index, other.hop_index);
+    magnitudes.swap(other.magnitudes);
+}
+
+void MultiResolutionAnalyzer::setHopSize(int hop) {
+    hop_size = std::max(0, hop);
+    schedule();
+    reset();
+}
+
+int MultiResolutionAnalyzer::getHopSize() const {
+    if (hop_size > 0) {
+        return hop_size;
+    }
+    return stages.empty() ? 0 : stages.back().analyzer->getFFTSize();
+}
+
+void MultiResolutionAnalyzer::setWindow(FFTAnalyzer::WindowType type) {
+    window_type = type;
+    for (Stage& stage : stages) {
+        stage.analyzer->setWindow(type);
+    }
+}
+
+void MultiResolutionAnalyzer::schedule() {
+    if (stages.empty()) {
+        return;
+    }
+
+    // Every size / OVERLAP samples, in whole hops
+    int hop = getHopSize();
+    long length = 1;
+    for (Stage& stage : stages) {
+        int size = stage.analyzer->getFFTSize();
+        stage.period = std::max(1, (int)std::lround((double)size / OVERLAP / hop));
+        stage.phase = 0;
+        length = std::min(MAX_SCHEDULE_HOPS, std::lcm(length, (long)stage.period));
+    }
+
+    // Place the most expensive transforms first, each at the phase whose
+    // busiest hop (so far) is least loaded
+    std::vector<size_t> order(stages.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return stages[a].cost > stages[b].cost;
+    });
+    std::vector<double> load(length, 0.0);
+    for (size_t index : order) {
+        Stage& stage = stages[index];
+        double best = -1.0;
+        for (int phase = 0; phase < stage.period; phase++) {
+            double busiest = 0.0;
+            for (long t = phase; t < length; t += stage.period) {
+                busiest = std::max(busiest, load[t]);
+            }
+            if (best < 0.0 || busiest < best) {
+                best = busiest;
+                stage.phase = phase;
+            }
+        }
+        for (long t = stage.phase; t < length; t += stage.period) {
+            load[t] += stage.cost;
+        }
+    }
+}
+
+bool MultiResolutionAnalyzer::addSample(float sample) {
+    if (stages.empty()) {
+        return false;
+    }
+    ring[write_pos] = sample;
+    ring[write_pos + ring_size] = sample;
+    write_pos = (write_pos + 1 == ring_size) ? 0 : write_pos + 1;
+    filled = std::min(filled + 1, ring_size);
+    since_hop++;
+    if (filled < ring_size || since_hop < getHopSize()) {
+        return false;
+    }
+    since_hop = 0;
+
+    // The first hop runs every stage so no range starts out empty
+    for (Stage& stage : stages) {
+        if (hop_index == 0 || hop_index % stage.period == stage.phase) {
+            runStage(stage);
+        }
+    }
+    hop_index++;
+    return true;
+}
+
+void MultiResolutionAnalyzer::runStage(Stage& stage) {
+    // The stage's window is the newest fft_size samples of the ring
+    int size = stage.analyzer->getFFTSize();
+    stage.analyzer->computeFFTFromBuffer(ring.data() + write_pos + ring_size - size, size);
+
+    // Nearest bin of the stage's grid for each output bin it covers
+    const std::vector<float>& source = stage.analyzer->getMagnitudes();
+    for (int bin = stage.first_bin; bin < stage.last_bin; bin++) {
+        int nearest = (int)(((long)bin * size + ring_size / 2) / ring_size);
+        magnitudes[bin] = stage.scale * source[nearest];
+    }
+}
+
+void MultiResolutionAnalyzer::reset() {
+    std::fill(ring.begin(), ring.end(), 0.0f);
+    std::fill(magnitudes.begin(), magnitudes.end(), 0.0f);
+    write_pos = 0;
+    filled = 0;
+    since_hop = 0;
+    hop_index = 0;
+}
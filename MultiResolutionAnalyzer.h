@@ -0,0 +1,99 @@
+#ifndef MULTIRESOLUTIONANALYZER_H
+#define MULTIRESOLUTIONANALYZER_H
+
+#include <vector>
+#include <memory>
+#include "FFTAnalyzer.h"
+
+// Analysis with a different FFT size per frequency range: long transforms
+// where bins need to be narrow (bass), short ones where timing matters more
+// (treble). All sizes read the latest samples from one shared input ring
+// and are merged into a single spectrum on the largest size's bin grid, so
+// the result can be displayed and filtered like a plain FFTAnalyzer
+// spectrum of getFFTSize().
+//
+// Each size is transformed every size / OVERLAP samples, rounded to whole
+// hops, and the hop at which each size's period starts is staggered so the
+// large transforms do not land on the same hop: per-hop cost stays close to
+// the average instead of spiking whenever they coincide.
+class MultiResolutionAnalyzer {
+public:
+    // One frequency range: transformed at fft_size, covering up to max_hz
+    // (the last range always runs to Nyquist)
+    struct Range {
+        int fft_size;
+        float max_hz;
+    };
+
+    static constexpr int OVERLAP = 4; // Transforms per window length
+
+    MultiResolutionAnalyzer();
+
+    MultiResolutionAnalyzer(const MultiResolutionAnalyzer&) = delete;
+    MultiResolutionAnalyzer& operator=(const MultiResolutionAnalyzer&) = delete;
+
+    // 8192 points below 250 Hz, 2048 up to 2.5 kHz and 512 above
+    static std::vector<Range> defaultLayout();
+
+    // Ranges ordered from low to high frequency, with non-increasing FFT
+    // sizes in FFTAnalyzer::MIN_FFT_SIZE..MAX_FFT_SIZE. Clears the input.
+    bool configure(const std::vector<Range>& layout, unsigned int sampleRate);
+    bool isConfigured() const { return !stages.empty(); }
+
+    // Exchange everything with other without allocating, so an analyzer
+    // configured elsewhere can be swapped in under a lock
+    void swap(MultiResolutionAnalyzer& other);
+
+    // Samples between merged spectra (0: the smallest FFT size). Clears
+    // the input.
+    void setHopSize(int hop);
+    int getHopSize() const;
+
+    void setWindow(FFTAnalyzer::WindowType type);
+    FFTAnalyzer::WindowType getWindow() const { return window_type; }
+
+    // Process a single sample; returns true when a new merged spectrum is
+    // ready (every hop, once the largest window is full)
+    bool addSample(float sample);
+
+    // Latest merged magnitudes (size: getFFTSize() / 2 + 1)
+    const std::vector<float>& getMagnitudes() const { return magnitudes; }
+
+    // Largest FFT size, which sets the output bin grid
+    int getFFTSize() const { return ring_size; }
+    unsigned int getSampleRate() const { return sample_rate; }
+
+    void reset();
+
+private:
+    struct Stage {
+        std::unique_ptr<FFTAnalyzer> analyzer;
+        int first_bin;  // Output bins [first_bin, last_bin) come from this stage
+        int last_bin;
+        float scale;    // Brings magnitudes to the largest size's level
+        int period;     // Hops between transforms
+        int phase;      // Hop within the period at which it runs
+        double cost;    // Relative cost of one transform
+    };
+
+    std::vector<Stage> stages;
+    unsigned int sample_rate;
+    int hop_size;   // As set; see getHopSize()
+    FFTAnalyzer::WindowType window_type;
+
+    // Mirrored like FFTAnalyzer's: the latest ring_size samples are always
+    // contiguous at ring + write_pos, and every stage's window is the tail
+    // of that
+    std::vector<float> ring;
+    int ring_size;
+    int write_pos;
+    int filled;
+    int since_hop;
+    long hop_index;
+    std::vector<float> magnitudes;
+
+    void schedule();
+    void runStage(Stage& stage);
+};
+
+#endif // MULTIRESOLUTIONANALYZER_H
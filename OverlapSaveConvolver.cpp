@@ -0,0 +1,188 @@
+#include "OverlapSaveConvolver.h"
+#include "FFTPlanCache.h"
+#include <fftw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Smallest transform worth the plan overhead
+constexpr int MIN_CONVOLUTION_SIZE = 64;
+
+} // namespace
+
+OverlapSaveConvolver::OverlapSaveConvolver()
+    : taps(0), fft_size(0), block_size(0), plans(nullptr), time_buffer(nullptr), spectrum_buffer(nullptr) {
+}
+
+OverlapSaveConvolver::~OverlapSaveConvolver() {
+    freeScratch();
+}
+
+OverlapSaveConvolver::OverlapSaveConvolver(const OverlapSaveConvolver& other)
+    : taps(other.taps), fft_size(other.fft_size), block_size(other.block_size),
+      kernel_spectrum(other.kernel_spectrum), plans(other.plans), channels(other.channels),
+      time_buffer(nullptr), spectrum_buffer(nullptr) {
+    allocateScratch();
+}
+
+OverlapSaveConvolver& OverlapSaveConvolver::operator=(const OverlapSaveConvolver& other) {
+    if (this != &other) {
+        taps = other.taps;
+        fft_size = other.fft_size;
+        block_size = other.block_size;
+        kernel_spectrum = other.kernel_spectrum;
+        plans = other.plans;
+        channels = other.channels;
+        allocateScratch();
+    }
+    return *this;
+}
+
+int OverlapSaveConvolver::fftSizeFor(int taps) {
+    int size = MIN_CONVOLUTION_SIZE;
+    while (size < 2 * (taps - 1)) {
+        size *= 2;
+    }
+    return size;
+}
+
+void OverlapSaveConvolver::allocateScratch() {
+    freeScratch();
+    if (fft_size > 0) {
+        time_buffer = fftwf_alloc_real(fft_size);
+        spectrum_buffer = reinterpret_cast<float*>(fftwf_alloc_complex(fft_size / 2 + 1));
+    }
+}
+
+void OverlapSaveConvolver::freeScratch() {
+    fftwf_free(time_buffer);
+    fftwf_free(spectrum_buffer);
+    time_buffer = nullptr;
+    spectrum_buffer = nullptr;
+}
+
+void OverlapSaveConvolver::setCoefficients(const std::vector<float>& coeffs) {
+    int newTaps = (int)coeffs.size();
+    if (newTaps == 0) {
+        taps = fft_size = block_size = 0;
+        kernel_spectrum.clear();
+        plans = nullptr;
+        freeScratch();
+        resizeChannels();
+        return;
+    }
+
+    bool resize = newTaps != taps;
+    if (resize) {
+        taps = newTaps;
+        fft_size = fftSizeFor(taps);
+        block_size = fft_size - taps + 1;
+        plans = &FFTPlanCache::get(fft_size);
+        allocateScratch();
+    }
+
+    // Kernel spectrum, with the inverse transform's 1 / N folded in
+    std::fill(time_buffer, time_buffer + fft_size, 0.0f);
+    for (int i = 0; i < taps; i++) {
+        time_buffer[i] = coeffs[i] / fft_size;
+    }
+    fftwf_execute_dft_r2c(plans->forward.load(std::memory_order_acquire), time_buffer,
+                          reinterpret_cast<fftwf_complex*>(spectrum_buffer));
+    kernel_spectrum.assign(spectrum_buffer, spectrum_buffer + 2 * (fft_size / 2 + 1));
+
+    if (resize) {
+        resizeChannels();
+    }
+}
+
+void OverlapSaveConvolver::setChannelCount(unsigned int count) {
+    if (count == channels.size()) {
+        return;
+    }
+    channels.resize(count);
+    resizeChannels();
+}
+
+void OverlapSaveConvolver::resizeChannels() {
+    for (Channel& channel : channels) {
+        channel.frame.assign(fft_size, 0.0f);
+        channel.output.assign(block_size, 0.0f);
+        channel.fill = 0;
+    }
+}
+
+void OverlapSaveConvolver::reset() {
+    for (Channel& channel : channels) {
+        std::fill(channel.frame.begin(), channel.frame.end(), 0.0f);
+        std::fill(channel.output.begin(), channel.output.end(), 0.0f);
+        channel.fill = 0;
+    }
+}
+
+bool OverlapSaveConvolver::copyStateFrom(const OverlapSaveConvolver& other) {
+    if (other.taps != taps || other.channels.size() != channels.size()) {
+        return false;
+    }
+    for (size_t ch = 0; ch < channels.size(); ch++) {
+        std::copy(other.channels[ch].frame.begin(), other.channels[ch].frame.end(), channels[ch].frame.begin());
+        std::copy(other.channels[ch].output.begin(), other.channels[ch].output.end(), channels[ch].output.begin());
+        channels[ch].fill = other.channels[ch].fill;
+    }
+    return true;
+}
+
+void OverlapSaveConvolver::process(const float* in, float* out, size_t count, unsigned int channel) {
+    if (taps == 0 || channel >= channels.size()) {
+        if (out != in) {
+            std::memmove(out, in, count * sizeof(float));
+        }
+        return;
+    }
+
+    Channel& state = channels[channel];
+    while (count > 0) {
+        // Take input into the block and hand out the previous block's
+        // output in step; the input is copied first, so in may alias out
+        size_t n = std::min(count, (size_t)(block_size - state.fill));
+        std::memcpy(state.frame.data() + taps - 1 + state.fill, in, n * sizeof(float));
+        std::memcpy(out, state.output.data() + state.fill, n * sizeof(float));
+        state.fill += (int)n;
+        in += n;
+        out += n;
+        count -= n;
+
+        if (state.fill == block_size) {
+            convolveBlock(state);
+            state.fill = 0;
+        }
+    }
+}
+
+void OverlapSaveConvolver::convolveBlock(Channel& channel) {
+    fftwf_complex* spectrum = reinterpret_cast<fftwf_complex*>(spectrum_buffer);
+    std::memcpy(time_buffer, channel.frame.data(), fft_size * sizeof(float));
+    fftwf_execute_dft_r2c(plans->forward.load(std::memory_order_acquire), time_buffer, spectrum);
+
+    const float* h = kernel_spectrum.data();
+    const int bins = fft_size / 2 + 1;
+    for (int k = 0; k < bins; k++) {
+        float re = spectrum[k][0];
+        float im = spectrum[k][1];
+        spectrum[k][0] = re * h[2 * k] - im * h[2 * k + 1];
+        spectrum[k][1] = re * h[2 * k + 1] + im * h[2 * k];
+    }
+    fftwf_execute_dft_c2r(plans->inverse.load(std::memory_order_acquire), spectrum, time_buffer);
+
+    // The first taps - 1 outputs are wrapped around (circular convolution)
+    // and discarded; the rest are the block's filtered samples
+    const float* valid = time_buffer + taps - 1;
+    for (int i = 0; i < block_size; i++) {
+        // Safety check: prevent NaN/Inf
+        channel.output[i] = std::isfinite(valid[i]) ? valid[i] : 0.0f;
+    }
+
+    // The newest taps - 1 samples become the next frame's overlap
+    std::memmove(channel.frame.data(), channel.frame.data() + block_size, (taps - 1) * sizeof(float));
+}
@@ -0,0 +1,77 @@
+#ifndef OVERLAPSAVECONVOLVER_H
+#define OVERLAPSAVECONVOLVER_H
+
+#include <vector>
+#include <cstddef>
+#include "FFTPlanCache.h"
+
+// FIR filtering by FFT fast convolution (overlap-save), for kernels too long
+// to run directly. The kernel's spectrum is computed once per coefficient
+// change; the input is then filtered getBlockSize() samples at a time with
+// one forward and one inverse transform of getFFTSize() points (plans from
+// FFTPlanCache), each frame carrying the previous taps - 1 samples as
+// overlap. Cost per sample grows with log(taps) instead of taps.
+//
+// Output is delayed by one block (getLatency()) on top of the filter's own
+// delay, since a block is only filtered once it is complete.
+class OverlapSaveConvolver {
+public:
+    OverlapSaveConvolver();
+    ~OverlapSaveConvolver();
+
+    OverlapSaveConvolver(const OverlapSaveConvolver& other);
+    OverlapSaveConvolver& operator=(const OverlapSaveConvolver& other);
+
+    // Transform size used for a kernel of taps taps: the smallest power of
+    // two of at least 2 (taps - 1), so a block is at least taps samples
+    static int fftSizeFor(int taps);
+
+    // Taps in convolution order (coeffs[0] weights the newest sample).
+    // Channel state is cleared when the tap count changes.
+    void setCoefficients(const std::vector<float>& coeffs);
+    int getTaps() const { return taps; }
+    bool empty() const { return taps == 0; }
+
+    // Number of channels with their own input frame; new channels start silent
+    void setChannelCount(unsigned int channels);
+
+    // Filter count samples of one channel; in and out may be the same buffer
+    void process(const float* in, float* out, size_t count, unsigned int channel);
+
+    // Zero every channel's input and pending output
+    void reset();
+
+    // Take over other's input frames and pending output if it has the same
+    // tap and channel counts (its pending output was filtered with its own
+    // kernel); false, changing nothing, otherwise
+    bool copyStateFrom(const OverlapSaveConvolver& other);
+
+    int getFFTSize() const { return fft_size; }
+    int getBlockSize() const { return block_size; }
+    int getLatency() const { return block_size; }
+
+private:
+    struct Channel {
+        std::vector<float> frame;  // taps - 1 overlap samples, then the block being filled
+        std::vector<float> output; // Filtered previous block, read out as the next fills
+        int fill;                  // Samples of the current block received so far
+    };
+
+    int taps;
+    int fft_size;
+    int block_size; // fft_size - taps + 1
+    std::vector<float> kernel_spectrum; // Interleaved complex, includes the 1 / fft_size scale
+    const FFTPlanCache::Plans* plans;   // Fetched with the coefficients, so process() never locks
+    std::vector<Channel> channels;
+
+    // FFTW scratch (fftwf_malloc aligned), shared by all channels
+    float* time_buffer;
+    float* spectrum_buffer; // fft_size / 2 + 1 interleaved complex values
+
+    void allocateScratch();
+    void freeScratch();
+    void resizeChannels();
+    void convolveBlock(Channel& channel);
+};
+
+#endif // OVERLAPSAVECONVOLVER_H
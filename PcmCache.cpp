@@ -0,0 +1,218 @@
+#include "PcmCache.h"
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'A', 'V', 'P', 'C', 'M', 0, 0, 0};
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr uint64_t DATA_OFFSET = 4096; // Page-aligned, so channel 0 is 64-byte aligned once mapped
+constexpr size_t HASH_SPAN = 1 << 20;
+constexpr size_t WRITE_CHUNK_FLOATS = 1 << 20;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t channels;
+    uint32_t sample_rate;
+    uint32_t reserved;
+    uint64_t frames;
+    uint64_t stride;
+    uint64_t data_offset;
+};
+
+// Whether a header read from a file of fileSize bytes describes data that
+// lies entirely inside it. Checked by division, so huge values in a corrupt
+// header cannot overflow their way past it.
+bool isValidHeader(const CacheHeader& header, uint64_t fileSize) {
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.channels == 0) {
+        return false;
+    }
+    if (header.frames > header.stride || header.data_offset < sizeof(CacheHeader) ||
+        header.data_offset > fileSize || header.data_offset % sizeof(float) != 0) {
+        return false;
+    }
+    return header.stride <= (fileSize - header.data_offset) / sizeof(float) / header.channels;
+}
+
+uint64_t fnv1a(uint64_t hash, const unsigned char* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+PcmCache::PcmCache()
+    : max_bytes(DEFAULT_MAX_BYTES) {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    if (xdg && *xdg) {
+        directory = std::string(xdg) + "/audio_visualizer/pcm";
+    } else if (home && *home) {
+        directory = std::string(home) + "/.cache/audio_visualizer/pcm";
+    }
+}
+
+std::string PcmCache::makeKey(const unsigned char* data, size_t size, int64_t mtime) const {
+    // Hashing the head and tail keeps a hit O(1) in file size; together with
+    // size and mtime that is enough to tell library files apart
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = fnv1a(hash, reinterpret_cast<const unsigned char*>(&size), sizeof(size));
+    hash = fnv1a(hash, reinterpret_cast<const unsigned char*>(&mtime), sizeof(mtime));
+    size_t head = std::min(size, HASH_SPAN);
+    hash = fnv1a(hash, data, head);
+    if (size > head) {
+        size_t tail = std::min(size - head, HASH_SPAN);
+        hash = fnv1a(hash, data + size - tail, tail);
+    }
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+    return key;
+}
+
+std::string PcmCache::pathFor(const std::string& key) const {
+    return directory + "/" + key + ".pcm";
+}
+
+bool PcmCache::load(const std::string& key, SampleBuffer& samples, unsigned int& sampleRate) const {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    int fd = open(pathFor(key).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat metadata;
+    CacheHeader header;
+    if (fstat(fd, &metadata) < 0 ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        !isValidHeader(header, (uint64_t)metadata.st_size)) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = metadata.st_size;
+    void* mapping = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // Bump the modification time: eviction treats it as the last use
+    futimens(fd, nullptr);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const float* data = reinterpret_cast<const float*>(static_cast<const char*>(mapping) + header.data_offset);
+    samples.adoptMapping(mapping, size, data, header.channels, header.frames, header.stride);
+    sampleRate = header.sample_rate;
+    return true;
+}
+
+bool PcmCache::store(const std::string& key, const SampleBuffer& samples, unsigned int sampleRate,
+                     const std::atomic<bool>& cancel) {
+    if (!isEnabled() || samples.empty()) {
+        return false;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+
+    // Write under a private name and rename, so readers never see a partial file
+    std::string path = pathFor(key);
+    std::string tmpPath = path + ".tmp." + std::to_string(getpid()) + "." +
+                          std::to_string(reinterpret_cast<uintptr_t>(&samples));
+    std::ofstream out(tmpPath, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    CacheHeader header = {};
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.channels = samples.getChannels();
+    header.sample_rate = sampleRate;
+    header.frames = samples.getFrames();
+    header.stride = samples.getStride();
+    header.data_offset = DATA_OFFSET;
+
+    std::vector<char> headerBlock(DATA_OFFSET, 0);
+    memcpy(headerBlock.data(), &header, sizeof(header));
+    out.write(headerBlock.data(), headerBlock.size());
+
+    // Channels are written with their padding so the file mirrors the store
+    std::vector<float> padding(samples.getStride() - samples.getFrames(), 0.0f);
+    for (unsigned int ch = 0; ch < samples.getChannels() && out && !cancel.load(); ch++) {
+        const float* data = samples.channel(ch);
+        for (size_t pos = 0; pos < samples.getFrames() && out && !cancel.load(); pos += WRITE_CHUNK_FLOATS) {
+            size_t count = std::min(WRITE_CHUNK_FLOATS, samples.getFrames() - pos);
+            out.write(reinterpret_cast<const char*>(data + pos), count * sizeof(float));
+        }
+        out.write(reinterpret_cast<const char*>(padding.data()), padding.size() * sizeof(float));
+    }
+    out.close();
+
+    if (!out || cancel.load() || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void PcmCache::evict() {
+    std::lock_guard<std::mutex> lock(evict_mutex);
+
+    struct Entry {
+        fs::file_time_type last_use;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+
+    std::error_code ec;
+    for (const fs::directory_entry& file : fs::directory_iterator(directory, ec)) {
+        if (file.path().extension() != ".pcm") {
+            continue;
+        }
+        uint64_t size = file.file_size(ec);
+        entries.push_back({file.last_write_time(ec), size, file.path()});
+        total += size;
+    }
+    if (total <= max_bytes) {
+        return;
+    }
+
+    // Oldest use first; unlinking a mapped entry is safe, the mapping survives
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.last_use < b.last_use; });
+    for (const Entry& entry : entries) {
+        if (total <= max_bytes) {
+            break;
+        }
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+            std::cout << "Evicted PCM cache entry " << entry.path.filename().string() << std::endl;
+        }
+    }
+}
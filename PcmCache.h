@@ -0,0 +1,45 @@
+#ifndef PCMCACHE_H
+#define PCMCACHE_H
+
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include "SampleBuffer.h"
+
+// On-disk cache of decoded float32 PCM. Each entry is a planar file laid out
+// exactly like SampleBuffer, so a hit is a single mmap with no decoding or
+// copying. Entries are evicted least-recently-used once the directory grows
+// past the size cap.
+class PcmCache {
+public:
+    static constexpr uint64_t DEFAULT_MAX_BYTES = 4ULL * 1024 * 1024 * 1024;
+
+    // Uses $XDG_CACHE_HOME/audio_visualizer/pcm (or ~/.cache/...)
+    PcmCache();
+
+    void setDirectory(const std::string& path) { directory = path; }
+    void setMaxBytes(uint64_t bytes) { max_bytes = bytes; }
+    bool isEnabled() const { return !directory.empty() && max_bytes > 0; }
+
+    // Key from file size, mtime and a hash of the first and last MiB of content
+    std::string makeKey(const unsigned char* data, size_t size, int64_t mtime) const;
+
+    // Map a cached entry into samples. Returns false on a miss.
+    bool load(const std::string& key, SampleBuffer& samples, unsigned int& sampleRate) const;
+
+    // Write an entry, then evict old ones. Checks cancel between chunks and
+    // leaves nothing behind if it is set.
+    bool store(const std::string& key, const SampleBuffer& samples, unsigned int sampleRate,
+               const std::atomic<bool>& cancel);
+
+private:
+    std::string directory;
+    uint64_t max_bytes;
+    std::mutex evict_mutex;
+
+    std::string pathFor(const std::string& key) const;
+    void evict();
+};
+
+#endif // PCMCACHE_H
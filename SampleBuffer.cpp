@@ -0,0 +1,85 @@
+#include "SampleBuffer.h"
+#include <cstdlib>
+#include <utility>
+#include <sys/mman.h>
+
+SampleBuffer::SampleBuffer()
+    : data(nullptr), stride(0), frames(0), channels(0),
+      mapping(nullptr), mapping_size(0) {
+}
+
+SampleBuffer::~SampleBuffer() {
+    clear();
+}
+
+SampleBuffer::SampleBuffer(SampleBuffer&& other) noexcept
+    : data(other.data), stride(other.stride), frames(other.frames), channels(other.channels),
+      mapping(other.mapping), mapping_size(other.mapping_size) {
+    other.data = nullptr;
+    other.stride = 0;
+    other.frames = 0;
+    other.channels = 0;
+    other.mapping = nullptr;
+    other.mapping_size = 0;
+}
+
+SampleBuffer& SampleBuffer::operator=(SampleBuffer&& other) noexcept {
+    if (this != &other) {
+        clear();
+        std::swap(data, other.data);
+        std::swap(stride, other.stride);
+        std::swap(frames, other.frames);
+        std::swap(channels, other.channels);
+        std::swap(mapping, other.mapping);
+        std::swap(mapping_size, other.mapping_size);
+    }
+    return *this;
+}
+
+bool SampleBuffer::allocate(unsigned int channelCount, size_t frameCount) {
+    clear();
+    if (channelCount == 0 || frameCount == 0) {
+        return true;
+    }
+
+    // Pad each channel so the next one also starts on an ALIGNMENT boundary
+    const size_t floatsPerLine = ALIGNMENT / sizeof(float);
+    size_t paddedStride = (frameCount + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+    size_t bytes = paddedStride * channelCount * sizeof(float);
+
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, ALIGNMENT, bytes) != 0) {
+        return false;
+    }
+
+    data = static_cast<float*>(ptr);
+    stride = paddedStride;
+    frames = frameCount;
+    channels = channelCount;
+    return true;
+}
+
+void SampleBuffer::adoptMapping(void* mappingBase, size_t mappingSize, const float* channelData,
+                                unsigned int channelCount, size_t frameCount, size_t channelStride) {
+    clear();
+    mapping = mappingBase;
+    mapping_size = mappingSize;
+    data = const_cast<float*>(channelData);
+    stride = channelStride;
+    frames = frameCount;
+    channels = channelCount;
+}
+
+void SampleBuffer::clear() {
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    } else {
+        free(data);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    data = nullptr;
+    stride = 0;
+    frames = 0;
+    channels = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef SAMPLEBUFFER_H
+#define SAMPLEBUFFER_H
+
+#include <cstddef>
+
+// Planar multichannel float store: one contiguous, 64-byte aligned array per
+// channel so per-channel kernels (FFT, FIR, export) can use aligned vector
+// loads. Memory use is channels x frames x 4 bytes plus at most 60 bytes of
+// padding per channel.
+class SampleBuffer {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    SampleBuffer();
+    ~SampleBuffer();
+
+    SampleBuffer(const SampleBuffer&) = delete;
+    SampleBuffer& operator=(const SampleBuffer&) = delete;
+    SampleBuffer(SampleBuffer&& other) noexcept;
+    SampleBuffer& operator=(SampleBuffer&& other) noexcept;
+
+    // Allocate uninitialized storage (drops any previous contents); the
+    // caller fills every frame, e.g. from parallel decode workers
+    bool allocate(unsigned int channels, size_t frames);
+
+    // Use a read-only memory mapping (e.g. a PCM cache file) as the store.
+    // channelData must point at channel 0 inside the mapping, with each
+    // further channel stride floats later. Takes ownership of the mapping.
+    void adoptMapping(void* mapping, size_t mappingSize, const float* channelData,
+                      unsigned int channels, size_t frames, size_t stride);
+
+    // Release storage
+    void clear();
+
+    // Floats between channel starts
+    size_t getStride() const { return stride; }
+    bool isMapped() const { return mapping != nullptr; }
+
+    unsigned int getChannels() const { return channels; }
+    size_t getFrames() const { return frames; }
+    bool empty() const { return frames == 0; }
+
+    // Writable access; not valid for mapped stores
+    float* channel(unsigned int ch) { return data + ch * stride; }
+    const float* channel(unsigned int ch) const { return data + ch * stride; }
+
+private:
+    float* data;
+    size_t stride; // Floats between channel starts (frames rounded up to ALIGNMENT)
+    size_t frames;
+    unsigned int channels;
+    void* mapping;       // Non-null when backed by mmap instead of the heap
+    size_t mapping_size;
+};
+
+#endif // SAMPLEBUFFER_H
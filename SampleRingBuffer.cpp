@@ -0,0 +1,72 @@
+#include "SampleRingBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+SampleRingBuffer::SampleRingBuffer(size_t capacity)
+    : mask(0), read_index(0), write_index(0) {
+    setCapacity(capacity);
+}
+
+void SampleRingBuffer::setCapacity(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    buffer.assign(capacity > 0 ? size : 0, 0.0f);
+    mask = buffer.empty() ? 0 : buffer.size() - 1;
+    read_index.store(0);
+    write_index.store(0);
+}
+
+size_t SampleRingBuffer::availableToRead() const {
+    return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_relaxed);
+}
+
+size_t SampleRingBuffer::availableToWrite() const {
+    return buffer.size() - (write_index.load(std::memory_order_relaxed) -
+                            read_index.load(std::memory_order_acquire));
+}
+
+size_t SampleRingBuffer::write(const float* data, size_t count) {
+    size_t w = write_index.load(std::memory_order_relaxed);
+    size_t r = read_index.load(std::memory_order_acquire);
+    size_t space = buffer.size() - (w - r);
+    count = std::min(count, space);
+    if (count == 0) {
+        return 0;
+    }
+
+    // Copy in at most two pieces (before and after the wrap point)
+    size_t start = w & mask;
+    size_t first = std::min(count, buffer.size() - start);
+    memcpy(&buffer[start], data, first * sizeof(float));
+    if (count > first) {
+        memcpy(&buffer[0], data + first, (count - first) * sizeof(float));
+    }
+
+    write_index.store(w + count, std::memory_order_release);
+    return count;
+}
+
+size_t SampleRingBuffer::read(float* data, size_t count) {
+    size_t r = read_index.load(std::memory_order_relaxed);
+    size_t w = write_index.load(std::memory_order_acquire);
+    count = std::min(count, w - r);
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t start = r & mask;
+    size_t first = std::min(count, buffer.size() - start);
+    memcpy(data, &buffer[start], first * sizeof(float));
+    if (count > first) {
+        memcpy(data + first, &buffer[0], (count - first) * sizeof(float));
+    }
+
+    read_index.store(r + count, std::memory_order_release);
+    return count;
+}
+
+void SampleRingBuffer::clear() {
+    read_index.store(write_index.load(std::memory_order_acquire), std::memory_order_release);
+}
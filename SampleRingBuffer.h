@@ -0,0 +1,38 @@
+#ifndef SAMPLERINGBUFFER_H
+#define SAMPLERINGBUFFER_H
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// Single-producer / single-consumer lock-free ring buffer of float samples.
+// The decoder thread writes and the audio callback reads; neither side ever
+// blocks or takes a lock, so it is safe to use from the real-time thread.
+class SampleRingBuffer {
+public:
+    explicit SampleRingBuffer(size_t capacity = 0);
+
+    // Resize the buffer (rounded up to a power of two). Not thread-safe:
+    // only call while neither producer nor consumer is running.
+    void setCapacity(size_t capacity);
+    size_t capacity() const { return buffer.size(); }
+
+    // Producer side: write up to count samples, returns how many were written
+    size_t write(const float* data, size_t count);
+    size_t availableToWrite() const;
+
+    // Consumer side: read up to count samples, returns how many were read
+    size_t read(float* data, size_t count);
+    size_t availableToRead() const;
+
+    // Drop all buffered samples. Only call while producer and consumer are idle.
+    void clear();
+
+private:
+    std::vector<float> buffer;
+    size_t mask;
+    std::atomic<size_t> read_index;
+    std::atomic<size_t> write_index;
+};
+
+#endif // SAMPLERINGBUFFER_H
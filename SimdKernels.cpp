@@ -0,0 +1,660 @@
+#include "SimdKernels.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON 1
+#endif
+
+namespace {
+
+uint16_t floatToHalfBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) {
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0); // Inf or NaN
+    }
+    if (exponent >= 31) {
+        return sign | 0x7C00; // Overflow to infinity
+    }
+
+    // Normal results drop 13 mantissa bits, subnormals more
+    int shift = 13;
+    uint32_t half;
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        shift = 14 - exponent;
+        half = mantissa >> shift;
+    } else {
+        half = ((uint32_t)exponent << 10) | (mantissa >> shift);
+    }
+
+    // Round to nearest even; a carry correctly bumps the exponent
+    uint32_t rest = mantissa & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1))) {
+        half++;
+    }
+    return sign | (uint16_t)half;
+}
+
+float halfBitsToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+
+    if (exponent == 0) {
+        float value = std::ldexp((float)mantissa, -24); // Zero or subnormal
+        return sign ? -value : value;
+    }
+
+    uint32_t bits = (exponent == 31) ? (sign | 0x7F800000 | (mantissa << 13))
+                                     : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Smallest power passed to the log, MIN_DECIBELS in dB
+constexpr float MIN_POWER = 1e-20f;
+constexpr float DB_PER_LOG2 = 3.01029995664f; // 10 log10(2)
+constexpr float LOG2_SERIES = 2.88539008178f; // 2 / ln(2)
+constexpr float SQRT2 = 1.41421356237f;
+
+// log2 of a positive normal float: split off the exponent, fold the
+// mantissa into [sqrt(1/2), sqrt(2)) and sum the atanh series of
+// t = (m - 1) / (m + 1) to t^9 (|t| < 0.172, so the error is ~1e-8).
+// The vector paths below follow the same steps.
+float fastLog2(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float)((int)(bits >> 23) - 127);
+    uint32_t mantissaBits = (bits & 0x7FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &mantissaBits, sizeof(m));
+    if (m > SQRT2) {
+        m *= 0.5f;
+        exponent += 1.0f;
+    }
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float series = 1.0f + t2 * (1.0f / 3 + t2 * (1.0f / 5 + t2 * (1.0f / 7 + t2 * (1.0f / 9))));
+    return exponent + LOG2_SERIES * t * series;
+}
+
+float powerToScale(float power, SimdKernels::SpectrumScale scale) {
+    switch (scale) {
+        case SimdKernels::SpectrumScale::Magnitude:
+            return std::sqrt(power);
+        case SimdKernels::SpectrumScale::Power:
+            return power;
+        case SimdKernels::SpectrumScale::Decibels:
+            break;
+    }
+    return DB_PER_LOG2 * fastLog2(std::max(power, MIN_POWER));
+}
+
+#if SIMD_X86
+bool hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+bool hasFma() {
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+}
+
+bool hasF16c() {
+    static const bool supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return supported;
+}
+
+__attribute__((target("avx2")))
+size_t fixedToFloatAvx2(const int32_t* in, float* out, size_t count, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t int16ToFloatAvx2(const int16_t* in, float* out, size_t count, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t floatToInt16Avx2(const float* in, int16_t* out, size_t count, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i), s));
+        __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), s));
+        // packs works per 128-bit lane, so restore the order afterwards
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+__m256 powerToScaleAvx2(__m256 power, SimdKernels::SpectrumScale scale) {
+    if (scale == SimdKernels::SpectrumScale::Magnitude) {
+        return _mm256_sqrt_ps(power);
+    }
+    if (scale == SimdKernels::SpectrumScale::Power) {
+        return power;
+    }
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256i bits = _mm256_castps_si256(_mm256_max_ps(power, _mm256_set1_ps(MIN_POWER)));
+    __m256 exponent = _mm256_cvtepi32_ps(
+        _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x7FFFFF)),
+                                                   _mm256_set1_epi32(0x3F800000)));
+    __m256 fold = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT2), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), fold);
+    exponent = _mm256_add_ps(exponent, _mm256_and_ps(fold, one));
+
+    __m256 t = _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 series = _mm256_add_ps(_mm256_mul_ps(t2, _mm256_set1_ps(1.0f / 9)), _mm256_set1_ps(1.0f / 7));
+    series = _mm256_add_ps(_mm256_mul_ps(t2, series), _mm256_set1_ps(1.0f / 5));
+    series = _mm256_add_ps(_mm256_mul_ps(t2, series), _mm256_set1_ps(1.0f / 3));
+    series = _mm256_add_ps(_mm256_mul_ps(t2, series), one);
+    __m256 log2 = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(LOG2_SERIES), t), series),
+                                exponent);
+    return _mm256_mul_ps(log2, _mm256_set1_ps(DB_PER_LOG2));
+}
+
+__attribute__((target("avx2")))
+size_t interleavedSpectrumAvx2(const float* in, float* out, size_t count, SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(in + 2 * i);     // Bins i .. i+3
+        __m256 b = _mm256_loadu_ps(in + 2 * i + 8); // Bins i+4 .. i+7
+        // hadd sums each (re^2, im^2) pair but interleaves a and b per
+        // 128-bit lane; the permute puts the bins back in order
+        __m256 power = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+        power = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), 0xD8));
+        _mm256_storeu_ps(out + i, powerToScaleAvx2(power, scale));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+size_t splitSpectrumAvx2(const float* real, const float* imag, float* out, size_t count,
+                         SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 re = _mm256_loadu_ps(real + i);
+        __m256 im = _mm256_loadu_ps(imag + i);
+        __m256 power = _mm256_add_ps(_mm256_mul_ps(re, re), _mm256_mul_ps(im, im));
+        _mm256_storeu_ps(out + i, powerToScaleAvx2(power, scale));
+    }
+    return i;
+}
+
+// Four accumulators hide the multiply-add latency; returns the partial sum
+// of the first *done elements
+__attribute__((target("avx2,fma")))
+float dotProductFma(const float* a, const float* b, size_t count, size_t* done) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    __m256 acc = _mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3));
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    *done = i;
+    return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx,f16c")))
+size_t halfToFloatF16c(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_cvtph_ps(v));
+    }
+    return i;
+}
+
+__attribute__((target("avx,f16c")))
+size_t floatToHalfF16c(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+    }
+    return i;
+}
+
+size_t int16ToFloatSse2(const int16_t* in, float* out, size_t count, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Widen with sign by placing each value in the high half and shifting down
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    return i;
+}
+
+size_t floatToInt16Sse2(const float* in, int16_t* out, size_t count, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), s));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), s));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+    return i;
+}
+
+__m128 powerToScaleSse2(__m128 power, SimdKernels::SpectrumScale scale) {
+    if (scale == SimdKernels::SpectrumScale::Magnitude) {
+        return _mm_sqrt_ps(power);
+    }
+    if (scale == SimdKernels::SpectrumScale::Power) {
+        return power;
+    }
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i bits = _mm_castps_si128(_mm_max_ps(power, _mm_set1_ps(MIN_POWER)));
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7FFFFF)),
+                                             _mm_set1_epi32(0x3F800000)));
+    __m128 fold = _mm_cmpgt_ps(m, _mm_set1_ps(SQRT2));
+    m = _mm_or_ps(_mm_andnot_ps(fold, m), _mm_and_ps(fold, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+    exponent = _mm_add_ps(exponent, _mm_and_ps(fold, one));
+
+    __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 series = _mm_add_ps(_mm_mul_ps(t2, _mm_set1_ps(1.0f / 9)), _mm_set1_ps(1.0f / 7));
+    series = _mm_add_ps(_mm_mul_ps(t2, series), _mm_set1_ps(1.0f / 5));
+    series = _mm_add_ps(_mm_mul_ps(t2, series), _mm_set1_ps(1.0f / 3));
+    series = _mm_add_ps(_mm_mul_ps(t2, series), one);
+    __m128 log2 = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(LOG2_SERIES), t), series), exponent);
+    return _mm_mul_ps(log2, _mm_set1_ps(DB_PER_LOG2));
+}
+
+size_t interleavedSpectrumSse2(const float* in, float* out, size_t count, SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(in + 2 * i);
+        __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        _mm_storeu_ps(out + i, powerToScaleSse2(power, scale));
+    }
+    return i;
+}
+
+size_t splitSpectrumSse2(const float* real, const float* imag, float* out, size_t count,
+                         SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 re = _mm_loadu_ps(real + i);
+        __m128 im = _mm_loadu_ps(imag + i);
+        __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+        _mm_storeu_ps(out + i, powerToScaleSse2(power, scale));
+    }
+    return i;
+}
+
+float dotProductSse2(const float* a, const float* b, size_t count, size_t* done) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(acc0, acc1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    *done = i;
+    return _mm_cvtss_f32(sum);
+}
+
+size_t fixedToFloatSse2(const int32_t* in, float* out, size_t count, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(v), s));
+    }
+    return i;
+}
+#endif
+
+#if SIMD_NEON
+size_t fixedToFloatNeon(const int32_t* in, float* out, size_t count, float scale) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t v = vcvtq_f32_s32(vld1q_s32(in + i));
+        vst1q_f32(out + i, vmulq_n_f32(v, scale));
+    }
+    return i;
+}
+
+size_t int16ToFloatNeon(const int16_t* in, float* out, size_t count, float scale) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    return i;
+}
+
+float dotProductNeon(const float* a, const float* b, size_t count, size_t* done) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+#if defined(__aarch64__)
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+#else
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+#endif
+    }
+    float32x4_t sum = vaddq_f32(acc0, acc1);
+    float32x2_t half = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    *done = i;
+    return vget_lane_f32(vpadd_f32(half, half), 0);
+}
+
+#if defined(__aarch64__)
+size_t floatToInt16Neon(const float* in, int16_t* out, size_t count, float scale) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t a = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in + i), scale));
+        int32x4_t b = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in + i + 4), scale));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+    return i;
+}
+
+float32x4_t powerToScaleNeon(float32x4_t power, SimdKernels::SpectrumScale scale) {
+    if (scale == SimdKernels::SpectrumScale::Magnitude) {
+        return vsqrtq_f32(power);
+    }
+    if (scale == SimdKernels::SpectrumScale::Power) {
+        return power;
+    }
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    uint32x4_t bits = vreinterpretq_u32_f32(vmaxq_f32(power, vdupq_n_f32(MIN_POWER)));
+    float32x4_t exponent = vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)),
+                                                   vdupq_n_s32(127)));
+    float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x7FFFFF)),
+                                                    vdupq_n_u32(0x3F800000)));
+    uint32x4_t fold = vcgtq_f32(m, vdupq_n_f32(SQRT2));
+    m = vbslq_f32(fold, vmulq_n_f32(m, 0.5f), m);
+    exponent = vaddq_f32(exponent, vbslq_f32(fold, one, vdupq_n_f32(0.0f)));
+
+    float32x4_t t = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+    float32x4_t t2 = vmulq_f32(t, t);
+    float32x4_t series = vfmaq_f32(vdupq_n_f32(1.0f / 7), t2, vdupq_n_f32(1.0f / 9));
+    series = vfmaq_f32(vdupq_n_f32(1.0f / 5), t2, series);
+    series = vfmaq_f32(vdupq_n_f32(1.0f / 3), t2, series);
+    series = vfmaq_f32(one, t2, series);
+    float32x4_t log2 = vfmaq_f32(exponent, vmulq_n_f32(t, LOG2_SERIES), series);
+    return vmulq_n_f32(log2, DB_PER_LOG2);
+}
+
+size_t interleavedSpectrumNeon(const float* in, float* out, size_t count, SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x2_t z = vld2q_f32(in + 2 * i); // Deinterleaves re / im
+        float32x4_t power = vfmaq_f32(vmulq_f32(z.val[1], z.val[1]), z.val[0], z.val[0]);
+        vst1q_f32(out + i, powerToScaleNeon(power, scale));
+    }
+    return i;
+}
+
+size_t splitSpectrumNeon(const float* real, const float* imag, float* out, size_t count,
+                         SimdKernels::SpectrumScale scale) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t re = vld1q_f32(real + i);
+        float32x4_t im = vld1q_f32(imag + i);
+        float32x4_t power = vfmaq_f32(vmulq_f32(im, im), re, re);
+        vst1q_f32(out + i, powerToScaleNeon(power, scale));
+    }
+    return i;
+}
+
+size_t halfToFloatNeon(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(in + i))));
+    }
+    return i;
+}
+
+size_t floatToHalfNeon(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(out + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(in + i))));
+    }
+    return i;
+}
+#endif
+#endif
+
+} // namespace
+
+void SimdKernels::fixedToFloat(const int32_t* in, float* out, size_t count, float scale) {
+    size_t i = 0;
+#if SIMD_X86
+    i = hasAvx2() ? fixedToFloatAvx2(in, out, count, scale)
+                  : fixedToFloatSse2(in, out, count, scale);
+#elif SIMD_NEON
+    i = fixedToFloatNeon(in, out, count, scale);
+#endif
+    // Scalar tail (or whole loop without SIMD)
+    for (; i < count; i++) {
+        out[i] = in[i] * scale;
+    }
+}
+
+void SimdKernels::int16ToFloat(const int16_t* in, float* out, size_t count, float scale) {
+    size_t i = 0;
+#if SIMD_X86
+    i = hasAvx2() ? int16ToFloatAvx2(in, out, count, scale)
+                  : int16ToFloatSse2(in, out, count, scale);
+#elif SIMD_NEON
+    i = int16ToFloatNeon(in, out, count, scale);
+#endif
+    for (; i < count; i++) {
+        out[i] = in[i] * scale;
+    }
+}
+
+void SimdKernels::floatToInt16(const float* in, int16_t* out, size_t count, float scale) {
+    size_t i = 0;
+#if SIMD_X86
+    i = hasAvx2() ? floatToInt16Avx2(in, out, count, scale)
+                  : floatToInt16Sse2(in, out, count, scale);
+#elif SIMD_NEON && defined(__aarch64__)
+    i = floatToInt16Neon(in, out, count, scale);
+#endif
+    // Same rounding (nearest even) and saturation as the vector paths
+    for (; i < count; i++) {
+        float value = std::nearbyint(in[i] * scale);
+        out[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, value));
+    }
+}
+
+void SimdKernels::halfToFloat(const uint16_t* in, float* out, size_t count) {
+    size_t i = 0;
+#if SIMD_X86
+    if (hasF16c()) {
+        i = halfToFloatF16c(in, out, count);
+    }
+#elif SIMD_NEON && defined(__aarch64__)
+    i = halfToFloatNeon(in, out, count);
+#endif
+    for (; i < count; i++) {
+        out[i] = halfBitsToFloat(in[i]);
+    }
+}
+
+void SimdKernels::floatToHalf(const float* in, uint16_t* out, size_t count) {
+    size_t i = 0;
+#if SIMD_X86
+    if (hasF16c()) {
+        i = floatToHalfF16c(in, out, count);
+    }
+#elif SIMD_NEON && defined(__aarch64__)
+    i = floatToHalfNeon(in, out, count);
+#endif
+    for (; i < count; i++) {
+        out[i] = floatToHalfBits(in[i]);
+    }
+}
+
+void SimdKernels::complexToSpectrum(const float* interleaved, float* out, size_t count,
+                                    SpectrumScale scale) {
+    size_t i = 0;
+#if SIMD_X86
+    i = hasAvx2() ? interleavedSpectrumAvx2(interleaved, out, count, scale)
+                  : interleavedSpectrumSse2(interleaved, out, count, scale);
+#elif SIMD_NEON && defined(__aarch64__)
+    i = interleavedSpectrumNeon(interleaved, out, count, scale);
+#endif
+    for (; i < count; i++) {
+        float re = interleaved[2 * i];
+        float im = interleaved[2 * i + 1];
+        out[i] = powerToScale(re * re + im * im, scale);
+    }
+}
+
+void SimdKernels::complexToSpectrum(const float* real, const float* imag, float* out, size_t count,
+                                    SpectrumScale scale) {
+    size_t i = 0;
+#if SIMD_X86
+    i = hasAvx2() ? splitSpectrumAvx2(real, imag, out, count, scale)
+                  : splitSpectrumSse2(real, imag, out, count, scale);
+#elif SIMD_NEON && defined(__aarch64__)
+    i = splitSpectrumNeon(real, imag, out, count, scale);
+#endif
+    for (; i < count; i++) {
+        out[i] = powerToScale(real[i] * real[i] + imag[i] * imag[i], scale);
+    }
+}
+
+float SimdKernels::dotProduct(const float* a, const float* b, size_t count) {
+    size_t i = 0;
+    float sum = 0.0f;
+#if SIMD_X86
+    sum = hasFma() ? dotProductFma(a, b, count, &i) : dotProductSse2(a, b, count, &i);
+#elif SIMD_NEON
+    sum = dotProductNeon(a, b, count, &i);
+#endif
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void SimdKernels::biquadCascade(const float* coeffs, float* state, size_t sections,
+                                float* const* channels, unsigned int channelCount, size_t count) {
+    channelCount = std::min(channelCount, BIQUAD_LANES);
+    float lanes[BIQUAD_LANES] = {};
+#if SIMD_X86 || SIMD_NEON
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned int ch = 0; ch < channelCount; ch++) {
+            lanes[ch] = channels[ch][i];
+        }
+#if SIMD_X86
+        __m128 x = _mm_loadu_ps(lanes);
+        for (size_t s = 0; s < sections; s++) {
+            const float* c = coeffs + 20 * s;
+            float* z = state + 8 * s;
+            __m128 s1 = _mm_loadu_ps(z);
+            __m128 s2 = _mm_loadu_ps(z + 4);
+            __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(c), x), s1);
+            s1 = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(c + 4), x), s2),
+                            _mm_mul_ps(_mm_loadu_ps(c + 12), y));
+            s2 = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(c + 8), x), _mm_mul_ps(_mm_loadu_ps(c + 16), y));
+            _mm_storeu_ps(z, s1);
+            _mm_storeu_ps(z + 4, s2);
+            x = y;
+        }
+        _mm_storeu_ps(lanes, x);
+#else
+        float32x4_t x = vld1q_f32(lanes);
+        for (size_t s = 0; s < sections; s++) {
+            const float* c = coeffs + 20 * s;
+            float* z = state + 8 * s;
+            float32x4_t y = vmlaq_f32(vld1q_f32(z), vld1q_f32(c), x);
+            float32x4_t s1 = vmlsq_f32(vmlaq_f32(vld1q_f32(z + 4), vld1q_f32(c + 4), x),
+                                       vld1q_f32(c + 12), y);
+            float32x4_t s2 = vmlsq_f32(vmulq_f32(vld1q_f32(c + 8), x), vld1q_f32(c + 16), y);
+            vst1q_f32(z, s1);
+            vst1q_f32(z + 4, s2);
+            x = y;
+        }
+        vst1q_f32(lanes, x);
+#endif
+        for (unsigned int ch = 0; ch < channelCount; ch++) {
+            channels[ch][i] = lanes[ch];
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned int ch = 0; ch < channelCount; ch++) {
+            float x = channels[ch][i];
+            for (size_t s = 0; s < sections; s++) {
+                const float* c = coeffs + 20 * s;
+                float* z = state + 8 * s;
+                float y = c[0] * x + z[ch];
+                z[ch] = c[4] * x + z[4 + ch] - c[12] * y;
+                z[4 + ch] = c[8] * x - c[16] * y;
+                x = y;
+            }
+            channels[ch][i] = x;
+        }
+    }
+    (void)lanes;
+#endif
+}
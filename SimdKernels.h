@@ -0,0 +1,61 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized inner loops shared by the decoder and DSP code. Each kernel
+// picks AVX2 (checked at runtime), SSE2 or NEON, with a scalar fallback,
+// so the build needs no extra architecture flags.
+class SimdKernels {
+public:
+    // Output of the spectrum kernels
+    enum class SpectrumScale {
+        Magnitude, // |z|
+        Power,     // |z|^2
+        Decibels   // 10 log10 |z|^2 (= 20 log10 |z|), fast log, floored at MIN_DECIBELS
+    };
+
+    static constexpr float MIN_DECIBELS = -200.0f;
+
+    // out[i] = in[i] * scale, converting signed fixed-point to float
+    static void fixedToFloat(const int32_t* in, float* out, size_t count, float scale);
+
+    // out[i] = in[i] * scale
+    static void int16ToFloat(const int16_t* in, float* out, size_t count, float scale);
+
+    // out[i] = in[i] * scale rounded to nearest, saturated to the int16 range
+    static void floatToInt16(const float* in, int16_t* out, size_t count, float scale);
+
+    // IEEE half precision (stored as raw bits) to float and back, rounding
+    // to nearest even; F16C on x86, native conversions on AArch64
+    static void halfToFloat(const uint16_t* in, float* out, size_t count);
+    static void floatToHalf(const float* in, uint16_t* out, size_t count);
+
+    // Spectrum of count complex bins in the chosen scale. The interleaved
+    // form takes (re, im) pairs as laid out by fftwf_complex; the split form
+    // takes separate real and imaginary arrays. The dB log is a range-reduced
+    // series, within a few 1e-5 dB (float rounding). This is the output stage of every
+    // analysis path (FFTAnalyzer, BatchFFT, ...).
+    static void complexToSpectrum(const float* interleaved, float* out, size_t count,
+                                  SpectrumScale scale);
+    static void complexToSpectrum(const float* real, const float* imag, float* out, size_t count,
+                                  SpectrumScale scale);
+
+    // sum of a[i] * b[i], with fused multiply-adds where the CPU has them;
+    // the inner product of the FIR filters
+    static float dotProduct(const float* a, const float* b, size_t count);
+
+    // Lanes of the biquad kernel
+    static constexpr unsigned int BIQUAD_LANES = 4;
+
+    // Run a cascade of biquad sections (transposed direct form II) in place
+    // over up to BIQUAD_LANES planar channels at once, one per vector lane.
+    // coeffs holds 20 floats per section: b0, b1, b2, a1, a2 (a0 = 1), each
+    // repeated BIQUAD_LANES times; state holds 8 per section: s1 for every
+    // lane, then s2.
+    static void biquadCascade(const float* coeffs, float* state, size_t sections,
+                              float* const* channels, unsigned int channelCount, size_t count);
+};
+
+#endif // SIMDKERNELS_H
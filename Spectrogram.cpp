@@ -0,0 +1,136 @@
+#include "Spectrogram.h"
+#include "AudioDecoder.h"
+#include "BatchFFT.h"
+#include "SampleBuffer.h"
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+constexpr size_t ROW_ALIGN_FLOATS = SampleBuffer::ALIGNMENT / sizeof(float);
+
+} // namespace
+
+Spectrogram::Spectrogram()
+    : data(nullptr), frames(0), row_stride(0), fft_size(0), hop_size(0),
+      window_type(FFTAnalyzer::WindowType::Rectangular) {
+}
+
+Spectrogram::~Spectrogram() {
+    clear();
+}
+
+void Spectrogram::clear() {
+    free(data);
+    data = nullptr;
+    frames = 0;
+    row_stride = 0;
+}
+
+bool Spectrogram::compute(const AudioDecoder& decoder, int fftSize, int hop,
+                          FFTAnalyzer::WindowType window, unsigned int threads,
+                          const std::atomic<bool>* cancel) {
+    clear();
+    size_t length = decoder.getLength();
+    if (!decoder.isLoaded() || decoder.isStreaming() || length < (size_t)fftSize) {
+        return false;
+    }
+
+    fft_size = fftSize;
+    hop_size = (hop > 0 && hop < fftSize) ? hop : fftSize;
+    window_type = window;
+    row_stride = (getBins() + ROW_ALIGN_FLOATS - 1) / ROW_ALIGN_FLOATS * ROW_ALIGN_FLOATS;
+    size_t total = (length - fft_size) / hop_size + 1;
+    while (total * row_stride * sizeof(float) > MAX_BYTES) {
+        hop_size *= 2;
+        total = (length - fft_size) / hop_size + 1;
+    }
+
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, SampleBuffer::ALIGNMENT, total * row_stride * sizeof(float)) != 0) {
+        std::cerr << "Failed to allocate spectrogram (" << total << " frames)" << std::endl;
+        return false;
+    }
+    data = static_cast<float*>(ptr);
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = (unsigned int)std::min<size_t>(threads, total);
+
+    // Contiguous frame ranges, so each worker reads its samples sequentially
+    std::vector<std::thread> workers;
+    std::vector<char> ok(threads, 0);
+    for (unsigned int t = 0; t < threads; t++) {
+        size_t first = total * t / threads;
+        size_t last = total * (t + 1) / threads;
+        workers.emplace_back([this, &decoder, &ok, t, first, last, cancel]() {
+            ok[t] = computeRange(decoder, first, last, cancel);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        clear();
+        return false;
+    }
+    frames = total;
+    return true;
+}
+
+bool Spectrogram::computeRange(const AudioDecoder& decoder, size_t first, size_t last,
+                               const std::atomic<bool>* cancel) {
+    BatchFFT engine(fft_size, hop_size, window_type);
+    const size_t batchFrames = engine.getBatchFrames();
+    const size_t span = (batchFrames - 1) * hop_size + fft_size; // Samples per batch
+    unsigned int channels = decoder.getChannels();
+
+    SampleBuffer block;
+    if (!block.allocate(channels, span)) {
+        return false;
+    }
+    std::vector<float*> blockChannels;
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        blockChannels.push_back(block.channel(ch));
+    }
+    std::vector<float> mono(span);
+    float mixScale = 1.0f / channels;
+
+    for (size_t f = first; f < last; f += batchFrames) {
+        if (cancel && cancel->load()) {
+            return false;
+        }
+        size_t count = std::min(batchFrames, last - f);
+        size_t needed = (count - 1) * hop_size + fft_size;
+        if (decoder.readFrames(f * hop_size, needed, blockChannels.data()) < needed) {
+            return false;
+        }
+
+        std::fill(mono.begin(), mono.begin() + needed, 0.0f);
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            const float* src = block.channel(ch);
+            for (size_t i = 0; i < needed; i++) {
+                mono[i] += src[i];
+            }
+        }
+        for (size_t i = 0; i < needed; i++) {
+            mono[i] *= mixScale;
+        }
+
+        engine.computeMagnitudes(mono.data(), count, data + f * row_stride, row_stride);
+    }
+    return true;
+}
+
+const float* Spectrogram::frameAtPosition(size_t position) const {
+    if (frames == 0) {
+        return nullptr;
+    }
+    size_t index = position < (size_t)fft_size ? 0 : (position - fft_size) / hop_size;
+    return frame(std::min(index, frames - 1));
+}
@@ -0,0 +1,61 @@
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include "FFTAnalyzer.h"
+
+class AudioDecoder;
+
+// Magnitude spectra of a whole track's mono mix, computed once after load
+// so playback visuals and scrubbing are a table lookup. Frame f covers
+// samples [f * hop, f * hop + fftSize). Rows are 64-byte aligned and
+// getRowStride() floats apart.
+class Spectrogram {
+public:
+    // Budget for one track; longer tracks get a coarser hop (see compute)
+    static constexpr size_t MAX_BYTES = (size_t)256 << 20;
+
+    Spectrogram();
+    ~Spectrogram();
+
+    Spectrogram(const Spectrogram&) = delete;
+    Spectrogram& operator=(const Spectrogram&) = delete;
+
+    // Compute from a loaded (non-streaming) decoder, splitting the frames
+    // into one contiguous range per thread (0: one per core), each running
+    // its own BatchFFT. The hop is doubled until the result fits MAX_BYTES.
+    // Returns false on failure or once *cancel is set.
+    bool compute(const AudioDecoder& decoder, int fftSize, int hop, FFTAnalyzer::WindowType window,
+                 unsigned int threads = 0, const std::atomic<bool>* cancel = nullptr);
+
+    void clear();
+
+    // Row for a frame index (< getFrames())
+    const float* frame(size_t index) const { return data + index * row_stride; }
+
+    // Row the live analyzer would show once position samples have played:
+    // the latest frame that ends at or before position
+    const float* frameAtPosition(size_t position) const;
+
+    size_t getFrames() const { return frames; }
+    int getBins() const { return fft_size / 2 + 1; }
+    size_t getRowStride() const { return row_stride; }
+    int getFFTSize() const { return fft_size; }
+    int getHopSize() const { return hop_size; }
+    FFTAnalyzer::WindowType getWindow() const { return window_type; }
+    bool empty() const { return frames == 0; }
+
+private:
+    float* data;
+    size_t frames;
+    size_t row_stride;
+    int fft_size;
+    int hop_size;
+    FFTAnalyzer::WindowType window_type;
+
+    bool computeRange(const AudioDecoder& decoder, size_t first, size_t last,
+                      const std::atomic<bool>* cancel);
+};
+
+#endif // SPECTROGRAM_H
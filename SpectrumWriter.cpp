@@ -0,0 +1,78 @@
+#include "SpectrumWriter.h"
+#include <cstring>
+#include "SimdKernels.h"
+
+namespace {
+
+constexpr char SPECTRUM_MAGIC[8] = {'A', 'V', 'S', 'P', 'E', 'C', 0, 1};
+
+void putLE32(unsigned char* p, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+void putLE64(unsigned char* p, std::uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+SpectrumWriter::SpectrumWriter()
+    : bins(0), encoding(Encoding::Float16), frames(0) {
+}
+
+SpectrumWriter::~SpectrumWriter() {
+    if (out.is_open()) {
+        close();
+    }
+}
+
+bool SpectrumWriter::open(const std::string& path, unsigned int sampleRate, unsigned int fftSize,
+                          unsigned int hop, unsigned int binCount, Encoding valueEncoding,
+                          SimdKernels::SpectrumScale scale) {
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    bins = binCount;
+    encoding = valueEncoding;
+    frames = 0;
+    half_frame.resize(encoding == Encoding::Float16 ? bins : 0);
+
+    // The frame count is patched in by close()
+    unsigned char header[HEADER_BYTES] = {};
+    memcpy(header, SPECTRUM_MAGIC, sizeof(SPECTRUM_MAGIC));
+    putLE32(header + 8, sampleRate);
+    putLE32(header + 12, fftSize);
+    putLE32(header + 16, hop);
+    putLE32(header + 20, bins);
+    putLE32(header + 24, static_cast<std::uint32_t>(encoding));
+    putLE32(header + 28, static_cast<std::uint32_t>(scale));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    return out.good();
+}
+
+bool SpectrumWriter::writeFrame(const float* magnitudes) {
+    // Values are written in host order; every supported target is little-endian
+    if (encoding == Encoding::Float16) {
+        SimdKernels::floatToHalf(magnitudes, half_frame.data(), bins);
+        out.write(reinterpret_cast<const char*>(half_frame.data()), bins * sizeof(uint16_t));
+    } else {
+        out.write(reinterpret_cast<const char*>(magnitudes), bins * sizeof(float));
+    }
+    frames++;
+    return out.good();
+}
+
+bool SpectrumWriter::close() {
+    unsigned char count[8];
+    putLE64(count, frames);
+    out.seekp(32);
+    out.write(reinterpret_cast<const char*>(count), sizeof(count));
+    bool ok = out.good();
+    out.close();
+    return ok;
+}
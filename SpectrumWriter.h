@@ -0,0 +1,54 @@
+#ifndef SPECTRUMWRITER_H
+#define SPECTRUMWRITER_H
+
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cstdint>
+#include "SimdKernels.h"
+
+// Writes a sequence of magnitude spectra to a compact binary file.
+//
+// Layout (little-endian):
+//   char     magic[8]     "AVSPEC\0\1"
+//   uint32   sample_rate
+//   uint32   fft_size
+//   uint32   hop          samples between frame starts
+//   uint32   bins         values per frame (fft_size / 2 + 1)
+//   uint32   encoding     0 = float32, 1 = IEEE half (float16)
+//   uint32   scale        0 = magnitude, 1 = power, 2 = dB (SimdKernels::SpectrumScale)
+//   uint64   frames
+//   frames x bins values, frame-major
+class SpectrumWriter {
+public:
+    enum class Encoding : uint32_t {
+        Float32 = 0,
+        Float16 = 1
+    };
+
+    static constexpr size_t HEADER_BYTES = 40;
+
+    SpectrumWriter();
+    ~SpectrumWriter();
+
+    bool open(const std::string& path, unsigned int sampleRate, unsigned int fftSize,
+              unsigned int hop, unsigned int bins, Encoding encoding,
+              SimdKernels::SpectrumScale scale = SimdKernels::SpectrumScale::Magnitude);
+
+    // Append one frame of bins magnitudes
+    bool writeFrame(const float* magnitudes);
+
+    // Fill in the frame count and close; returns false if any write failed
+    bool close();
+
+    uint64_t getFrames() const { return frames; }
+
+private:
+    std::ofstream out;
+    unsigned int bins;
+    Encoding encoding;
+    uint64_t frames;
+    std::vector<uint16_t> half_frame;
+};
+
+#endif // SPECTRUMWRITER_H
@@ -0,0 +1,178 @@
+#include "WavFile.h"
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr std::uint16_t WAVE_FORMAT_PCM = 0x0001;
+constexpr std::uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+constexpr std::uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+inline std::uint16_t readLE16(const unsigned char* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline std::uint32_t readLE32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) |
+           (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) |
+           (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+inline float convertInt16(const unsigned char* p) {
+    return static_cast<std::int16_t>(readLE16(p)) * (1.0f / 32768.0f);
+}
+
+inline float convertInt24(const unsigned char* p) {
+    std::int32_t value = p[0] | (p[1] << 8) | (p[2] << 16);
+    value = (value ^ 0x800000) - 0x800000; // Sign-extend bit 23
+    return value * (1.0f / 8388608.0f);
+}
+
+inline float convertInt32(const unsigned char* p) {
+    return static_cast<std::int32_t>(readLE32(p)) * (1.0f / 2147483648.0f);
+}
+
+inline float convertFloat32(const unsigned char* p) {
+    std::uint32_t bits = readLE32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Gather one channel at a time so each output array is written contiguously
+template <float (*Convert)(const unsigned char*)>
+void deinterleave(const unsigned char* src, size_t count, size_t frameBytes,
+                  unsigned int channels, size_t sampleBytes, float* const* out) {
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        const unsigned char* p = src + ch * sampleBytes;
+        float* dst = out[ch];
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = Convert(p);
+            p += frameBytes;
+        }
+    }
+}
+
+} // namespace
+
+WavFile::WavFile()
+    : pcm(nullptr), frames(0), frame_bytes(0), sample_rate(0), channels(0),
+      format(Format::Int16) {
+}
+
+bool WavFile::isWav(const unsigned char* data, size_t size) {
+    return data && size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0;
+}
+
+bool WavFile::open(const unsigned char* data, size_t size) {
+    close();
+    if (!isWav(data, size)) {
+        return false;
+    }
+
+    // Walk the chunk list; chunks are padded to an even number of bytes
+    bool have_format = false;
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const unsigned char* chunk = data + pos;
+        size_t chunk_size = readLE32(chunk + 4);
+        size_t body = pos + 8;
+        size_t available = std::min(chunk_size, size - body);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (!parseFormat(data + body, available)) {
+                return false;
+            }
+            have_format = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                std::cerr << "WAV data chunk before fmt chunk" << std::endl;
+                return false;
+            }
+            // A streamed header leaves the size 0 or 0xFFFFFFFF: the data runs to
+            // the end of the file. A truncated file keeps what is present.
+            if (chunk_size == 0 || chunk_size == 0xFFFFFFFF) {
+                available = size - body;
+            }
+            pcm = data + body;
+            frames = available / frame_bytes;
+            return true;
+        }
+
+        pos = body + chunk_size + (chunk_size & 1);
+    }
+
+    std::cerr << "WAV file has no data chunk" << std::endl;
+    return false;
+}
+
+bool WavFile::parseFormat(const unsigned char* chunk, size_t size) {
+    if (size < 16) {
+        return false;
+    }
+
+    std::uint16_t tag = readLE16(chunk);
+    channels = readLE16(chunk + 2);
+    sample_rate = readLE32(chunk + 4);
+    unsigned int bits = readLE16(chunk + 14);
+
+    // WAVE_FORMAT_EXTENSIBLE carries the real format in its sub-format GUID
+    if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 26) {
+        tag = readLE16(chunk + 24);
+    }
+
+    if (tag == WAVE_FORMAT_PCM && bits == 16) {
+        format = Format::Int16;
+    } else if (tag == WAVE_FORMAT_PCM && bits == 24) {
+        format = Format::Int24;
+    } else if (tag == WAVE_FORMAT_PCM && bits == 32) {
+        format = Format::Int32;
+    } else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32) {
+        format = Format::Float32;
+    } else {
+        std::cerr << "Unsupported WAV format (tag " << tag << ", " << bits << " bits)" << std::endl;
+        return false;
+    }
+
+    if (channels == 0 || sample_rate == 0) {
+        return false;
+    }
+    frame_bytes = (size_t)channels * (bits / 8);
+    return true;
+}
+
+void WavFile::close() {
+    pcm = nullptr;
+    frames = 0;
+    frame_bytes = 0;
+    sample_rate = 0;
+    channels = 0;
+    format = Format::Int16;
+}
+
+size_t WavFile::readFrames(size_t start, size_t count, float* const* out) const {
+    if (!pcm || start >= frames) {
+        return 0;
+    }
+    count = std::min(count, frames - start);
+
+    const unsigned char* src = pcm + start * frame_bytes;
+    size_t sample_bytes = frame_bytes / channels;
+    switch (format) {
+        case Format::Int16:
+            deinterleave<convertInt16>(src, count, frame_bytes, channels, sample_bytes, out);
+            break;
+        case Format::Int24:
+            deinterleave<convertInt24>(src, count, frame_bytes, channels, sample_bytes, out);
+            break;
+        case Format::Int32:
+            deinterleave<convertInt32>(src, count, frame_bytes, channels, sample_bytes, out);
+            break;
+        case Format::Float32:
+            deinterleave<convertFloat32>(src, count, frame_bytes, channels, sample_bytes, out);
+            break;
+    }
+    return count;
+}
@@ -0,0 +1,49 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// RIFF/WAVE reader over a memory-mapped file. PCM is never copied up front:
+// readFrames converts only the requested block from the mapping, so opening
+// a file costs a header parse regardless of its size.
+class WavFile {
+public:
+    enum class Format {
+        Int16,
+        Int24,
+        Int32,
+        Float32
+    };
+
+    WavFile();
+
+    // Check for the RIFF/WAVE signature
+    static bool isWav(const unsigned char* data, size_t size);
+
+    // Parse the header; data must stay mapped while this object is used
+    bool open(const unsigned char* data, size_t size);
+    void close();
+
+    bool isOpen() const { return pcm != nullptr; }
+    unsigned int getSampleRate() const { return sample_rate; }
+    unsigned int getChannels() const { return channels; }
+    size_t getFrames() const { return frames; }
+    Format getFormat() const { return format; }
+
+    // Convert count frames starting at start into one float array per channel
+    // (normalized to [-1, 1]). Returns the number of frames produced.
+    size_t readFrames(size_t start, size_t count, float* const* out) const;
+
+private:
+    const unsigned char* pcm; // Start of the data chunk inside the mapping
+    size_t frames;
+    size_t frame_bytes;
+    unsigned int sample_rate;
+    unsigned int channels;
+    Format format;
+
+    bool parseFormat(const unsigned char* chunk, size_t size);
+};
+
+#endif // WAVFILE_H
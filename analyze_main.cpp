@@ -0,0 +1,410 @@
+// Headless batch analysis: decodes every input track and writes its FFT
+// magnitude spectra (the same frames the visualizer shows) to a binary
+// .spec file, see SpectrumWriter.h. Files are spread over a pool of worker
+// threads, one decoder and batch FFT engine per thread.
+//
+// Usage: audio_analyze [-j threads] [-o outdir] [--format f16|f32]
+//                      [--fft-size n] [--hop n] [--window rect|hann|bh]
+//                      [--scale mag|power|db] [--check-precision] [--list file]
+//                      <file or directory>...
+
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include "AudioDecoder.h"
+#include "FFTAnalyzer.h"
+#include "BatchFFT.h"
+#include "FFTPlanCache.h"
+#include "SampleBuffer.h"
+#include "SpectrumWriter.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Swallows everything written to it
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Job {
+    fs::path input;
+    fs::path output;
+};
+
+// Redoes frames in double precision and measures how far the float rows
+// written (BatchFFT, in the chosen scale) are from it
+class PrecisionCheck {
+public:
+    // dB rows are compared over this range below the peak; further down the
+    // float transform's own rounding noise is all there is
+    static constexpr double DB_RANGE = 120.0;
+
+    PrecisionCheck(int fftSize, FFTAnalyzer::WindowType windowType, SimdKernels::SpectrumScale scale)
+        : fft_size(fftSize), scale(scale), window(fftSize), reference(fftSize / 2 + 1) {
+        FFTAnalyzer::fillWindow(windowType, window.data(), fftSize);
+        in = fftw_alloc_real(fftSize);
+        out = fftw_alloc_complex(fftSize / 2 + 1);
+    }
+
+    ~PrecisionCheck() {
+        fftw_free(in);
+        fftw_free(out);
+    }
+
+    PrecisionCheck(const PrecisionCheck&) = delete;
+    PrecisionCheck& operator=(const PrecisionCheck&) = delete;
+
+    // Largest difference of row, the spectrum written for frame: relative
+    // to the reference peak, or in dB for dB rows (0 for silence)
+    double compare(const float* frame, const float* row) {
+        for (int i = 0; i < fft_size; i++) {
+            in[i] = frame[i] * window[i];
+        }
+        fftw_execute_dft_r2c(FFTPlanCache::getReference(fft_size), in, out);
+
+        double peak = -HUGE_VAL;
+        for (size_t k = 0; k < reference.size(); k++) {
+            double power = out[k][0] * out[k][0] + out[k][1] * out[k][1];
+            switch (scale) {
+            case SimdKernels::SpectrumScale::Magnitude:
+                reference[k] = std::sqrt(power);
+                break;
+            case SimdKernels::SpectrumScale::Power:
+                reference[k] = power;
+                break;
+            case SimdKernels::SpectrumScale::Decibels:
+                reference[k] = std::max((double)SimdKernels::MIN_DECIBELS, 10.0 * std::log10(power));
+                break;
+            }
+            peak = std::max(peak, reference[k]);
+        }
+
+        double maxError = 0.0;
+        for (size_t k = 0; k < reference.size(); k++) {
+            if (scale != SimdKernels::SpectrumScale::Decibels || reference[k] >= peak - DB_RANGE) {
+                maxError = std::max(maxError, std::fabs(reference[k] - (double)row[k]));
+            }
+        }
+        if (scale == SimdKernels::SpectrumScale::Decibels) {
+            return (peak > SimdKernels::MIN_DECIBELS) ? maxError : 0.0;
+        }
+        return (peak > 0.0) ? maxError / peak : 0.0;
+    }
+
+private:
+    int fft_size;
+    SimdKernels::SpectrumScale scale;
+    std::vector<float> window;
+    std::vector<double> reference;
+    double* in;
+    fftw_complex* out;
+};
+
+struct Options {
+    unsigned int threads = 0;
+    int fft_size = FFTAnalyzer::DEFAULT_FFT_SIZE;
+    int hop_size = 0; // FFT size, no overlap
+    FFTAnalyzer::WindowType window = FFTAnalyzer::WindowType::Rectangular;
+    fs::path output_dir = ".";
+    SpectrumWriter::Encoding encoding = SpectrumWriter::Encoding::Float16;
+    SimdKernels::SpectrumScale scale = SimdKernels::SpectrumScale::Magnitude;
+    bool check_precision = false;
+    std::vector<std::string> inputs;
+};
+
+void printUsage() {
+    std::cerr << "Usage: audio_analyze [-j threads] [-o outdir] [--format f16|f32]\n"
+                 "                     [--fft-size n] [--hop n] [--window rect|hann|bh]\n"
+                 "                     [--scale mag|power|db] [--check-precision] [--list file]\n"
+                 "                     <file or directory>...\n"
+                 "Writes <outdir>/<name>.spec for each MP3/WAV input; directories\n"
+                 "are searched recursively and their layout is kept under outdir.\n"
+                 "--check-precision also redoes every FFT in double precision and\n"
+                 "reports the largest error of the spectra written, relative to peak\n"
+                 "(with --scale db: in dB, over bins within 120 dB of the peak).\n"
+                 "Power spectra overflow float16 quickly; use --format f32 with them.\n";
+}
+
+bool isAudioFile(const fs::path& path) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".mp3" || ext == ".wav";
+}
+
+bool parseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "-j" && hasValue) {
+            options.threads = (unsigned int)std::max(1, atoi(argv[++i]));
+        } else if (arg == "--fft-size" && hasValue) {
+            options.fft_size = atoi(argv[++i]);
+            if (options.fft_size < FFTAnalyzer::MIN_FFT_SIZE || options.fft_size > FFTAnalyzer::MAX_FFT_SIZE) {
+                std::cerr << "FFT size must be " << FFTAnalyzer::MIN_FFT_SIZE << ".."
+                          << FFTAnalyzer::MAX_FFT_SIZE << std::endl;
+                return false;
+            }
+        } else if (arg == "--hop" && hasValue) {
+            options.hop_size = std::max(0, atoi(argv[++i]));
+        } else if (arg == "--window" && hasValue) {
+            std::string window = argv[++i];
+            if (window == "rect") {
+                options.window = FFTAnalyzer::WindowType::Rectangular;
+            } else if (window == "hann") {
+                options.window = FFTAnalyzer::WindowType::Hann;
+            } else if (window == "bh") {
+                options.window = FFTAnalyzer::WindowType::BlackmanHarris;
+            } else {
+                std::cerr << "Unknown window: " << window << std::endl;
+                return false;
+            }
+        } else if (arg == "--scale" && hasValue) {
+            std::string scale = argv[++i];
+            if (scale == "mag") {
+                options.scale = SimdKernels::SpectrumScale::Magnitude;
+            } else if (scale == "power") {
+                options.scale = SimdKernels::SpectrumScale::Power;
+            } else if (scale == "db") {
+                options.scale = SimdKernels::SpectrumScale::Decibels;
+            } else {
+                std::cerr << "Unknown scale: " << scale << std::endl;
+                return false;
+            }
+        } else if (arg == "--check-precision") {
+            options.check_precision = true;
+        } else if (arg == "-o" && hasValue) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--format" && hasValue) {
+            std::string format = argv[++i];
+            if (format == "f16") {
+                options.encoding = SpectrumWriter::Encoding::Float16;
+            } else if (format == "f32") {
+                options.encoding = SpectrumWriter::Encoding::Float32;
+            } else {
+                std::cerr << "Unknown format: " << format << std::endl;
+                return false;
+            }
+        } else if (arg == "--list" && hasValue) {
+            // One path per line
+            std::ifstream list(argv[++i]);
+            if (!list.is_open()) {
+                std::cerr << "Failed to open list: " << argv[i] << std::endl;
+                return false;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty()) {
+                    options.inputs.push_back(line);
+                }
+            }
+        } else if (arg == "-h" || arg == "--help" || arg[0] == '-') {
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (options.hop_size > options.fft_size) {
+        // Frames further apart than they are long would skip input
+        std::cerr << "Hop size must not exceed the FFT size (" << options.fft_size << ")" << std::endl;
+        return false;
+    }
+    return !options.inputs.empty();
+}
+
+std::vector<Job> collectJobs(const Options& options) {
+    std::vector<Job> jobs;
+    for (const std::string& input : options.inputs) {
+        fs::path path(input);
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path, ec)) {
+                if (entry.is_regular_file(ec) && isAudioFile(entry.path())) {
+                    fs::path relative = fs::relative(entry.path(), path, ec);
+                    jobs.push_back({entry.path(), options.output_dir / relative.replace_extension(".spec")});
+                }
+            }
+        } else if (fs::exists(path, ec)) {
+            jobs.push_back({path, options.output_dir / path.filename().replace_extension(".spec")});
+        } else {
+            std::cerr << "No such file or directory: " << input << std::endl;
+        }
+    }
+    return jobs;
+}
+
+// Decode one track and write a spectrum of its mono mix every hop, once a
+// full FFT frame is in. Frames are transformed a batch at a time. Returns
+// the number of spectra written, or -1 on failure. With checker set, every
+// spectrum written is also checked against it and precisionError receives
+// the worst float-vs-double error seen.
+long analyzeFile(const Job& job, AudioDecoder& decoder, BatchFFT& engine,
+                 SpectrumWriter::Encoding encoding, PrecisionCheck* checker,
+                 double* precisionError) {
+    if (!decoder.loadFile(job.input.string())) {
+        return -1;
+    }
+
+    unsigned int channels = decoder.getChannels();
+    size_t length = decoder.getLength();
+    const size_t fftSize = engine.getFFTSize();
+    const size_t hop = engine.getHopSize();
+    const size_t bins = engine.getBins();
+    const size_t batchFrames = engine.getBatchFrames();
+
+    // One batch of new frames per read; what is left of the mono mix after
+    // a batch (under one FFT frame, in steady state) is carried over
+    const size_t blockFrames = batchFrames * hop;
+    SampleBuffer block;
+    if (!block.allocate(channels, blockFrames)) {
+        return -1;
+    }
+    std::vector<float*> blockChannels;
+    for (unsigned int ch = 0; ch < channels; ch++) {
+        blockChannels.push_back(block.channel(ch));
+    }
+
+    std::error_code ec;
+    fs::create_directories(job.output.parent_path(), ec);
+    SpectrumWriter writer;
+    if (!writer.open(job.output.string(), decoder.getSampleRate(), fftSize, hop, bins, encoding,
+                     engine.getSpectrumScale())) {
+        return -1;
+    }
+
+    std::vector<float> mono(blockFrames + fftSize);
+    std::vector<float> spectrogram(batchFrames * bins);
+    size_t pending = 0;
+    float mixScale = 1.0f / channels;
+    for (size_t start = 0; start < length; ) {
+        size_t got = decoder.readFrames(start, blockFrames, blockChannels.data());
+        if (got == 0) {
+            break;
+        }
+        start += got;
+
+        float* dst = &mono[pending];
+        std::fill(dst, dst + got, 0.0f);
+        for (unsigned int ch = 0; ch < channels; ch++) {
+            const float* src = block.channel(ch);
+            for (size_t i = 0; i < got; i++) {
+                dst[i] += src[i];
+            }
+        }
+        for (size_t i = 0; i < got; i++) {
+            dst[i] *= mixScale;
+        }
+        pending += got;
+
+        size_t frames = std::min(engine.frameCount(pending), batchFrames);
+        if (frames == 0) {
+            continue;
+        }
+        engine.computeMagnitudes(mono.data(), frames, spectrogram.data());
+        for (size_t f = 0; f < frames; f++) {
+            writer.writeFrame(&spectrogram[f * bins]);
+            if (checker) {
+                *precisionError = std::max(*precisionError,
+                                           checker->compare(&mono[f * hop], &spectrogram[f * bins]));
+            }
+        }
+
+        size_t consumed = frames * hop;
+        std::copy(mono.begin() + consumed, mono.begin() + pending, mono.begin());
+        pending -= consumed;
+    }
+
+    long frames = (long)writer.getFrames();
+    if (!writer.close()) {
+        return -1;
+    }
+    decoder.clear();
+    return frames;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    std::vector<Job> jobs = collectJobs(options);
+    if (jobs.empty()) {
+        std::cerr << "No MP3 or WAV files found" << std::endl;
+        return 1;
+    }
+
+    unsigned int threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned int)std::min<size_t>(threads, jobs.size());
+
+    // The decoder logs per-file details to std::cout; keep stdout for the
+    // one-line-per-file report instead
+    std::ostream report(std::cout.rdbuf());
+    NullBuffer discard;
+    std::cout.rdbuf(&discard);
+
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failed(0);
+    std::mutex report_mutex;
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) {
+        pool.emplace_back([&]() {
+            // Parallelism is across files, so each decoder stays single-threaded
+            AudioDecoder decoder;
+            decoder.setDecodeThreads(1);
+            BatchFFT engine(options.fft_size, options.hop_size, options.window);
+            engine.setSpectrumScale(options.scale);
+            std::unique_ptr<PrecisionCheck> checker;
+            if (options.check_precision) {
+                checker.reset(new PrecisionCheck(options.fft_size, options.window, options.scale));
+            }
+
+            for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+                double precisionError = 0.0;
+                long frames = analyzeFile(jobs[i], decoder, engine, options.encoding,
+                                          checker.get(), &precisionError);
+                std::ostringstream line;
+                line << "[" << (i + 1) << "/" << jobs.size() << "] " << jobs[i].input.string();
+                if (frames < 0) {
+                    failed++;
+                    line << ": FAILED";
+                } else {
+                    line << " -> " << jobs[i].output.string() << " (" << frames << " spectra";
+                    if (options.check_precision) {
+                        line << ", max float error " << precisionError;
+                        if (options.scale == SimdKernels::SpectrumScale::Decibels) {
+                            line << " dB";
+                        }
+                    }
+                    line << ")";
+                }
+                std::lock_guard<std::mutex> lock(report_mutex);
+                report << line.str() << std::endl;
+            }
+        });
+    }
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    FFTPlanCache::saveWisdom();
+
+    std::cout.rdbuf(report.rdbuf());
+    std::cerr << "Analyzed " << (jobs.size() - failed.load()) << " of " << jobs.size()
+              << " files on " << threads << " thread(s)" << std::endl;
+    return failed.load() ? 1 : 0;
+}